@@ -0,0 +1,124 @@
+#include "ansi_terminal.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// the same pairs setup_colors() gives ncurses, foreground on black
+static const char* PAIR_SGR[] = {
+    "\x1b[0m",
+    "\x1b[0;31;40m",
+    "\x1b[0;32;40m",
+    "\x1b[0;34;40m",
+    "\x1b[0;36;40m",
+    "\x1b[0;33;40m",
+};
+#define PAIR_SGR_COUNT (sizeof(PAIR_SGR) / sizeof(PAIR_SGR[0]))
+
+// unchanged cells in the current color shorter than this are resent instead of
+// moving the cursor over them (a cursor move is at least 6 bytes)
+#define ANSI_GAP_MAX 4
+
+AnsiTerminal::AnsiTerminal()
+    : fd(-1), raw(false), rows(0), cols(0), cursor_y(-1), cursor_x(-1), current_color(-1) {}
+
+AnsiTerminal::~AnsiTerminal() {
+    close();
+}
+
+bool_t AnsiTerminal::open(i32 target) {
+    fd = target;
+    if (isatty(fd) && tcgetattr(fd, &saved) == 0) {
+        struct termios mode = saved;
+        cfmakeraw(&mode);
+        raw = tcsetattr(fd, TCSANOW, &mode) == 0;
+    }
+    out.assign("\x1b[?1049h\x1b[?25l\x1b[0m\x1b[2J");
+    cursor_y = -1;
+    current_color = 0;
+    return flush();
+}
+
+void AnsiTerminal::close() {
+    if (fd < 0) return;
+    out.assign("\x1b[0m\x1b[?25h\x1b[?1049l");
+    flush();
+    if (raw) tcsetattr(fd, TCSANOW, &saved);
+    raw = false;
+    fd = -1;
+}
+
+void AnsiTerminal::resize(i32 new_rows, i32 new_cols) {
+    rows = new_rows;
+    cols = new_cols;
+    Cell unknown = { 0, 0xFF };
+    front.assign((size_t)rows * cols, unknown);
+    cursor_y = -1;
+}
+
+void AnsiTerminal::move_to(i32 y, i32 x) {
+    char seq[24];
+    i32 len = snprintf(seq, sizeof(seq), "\x1b[%d;%dH", y + 1, x + 1);
+    out.append(seq, (size_t)len);
+    cursor_y = y;
+    cursor_x = x;
+}
+
+void AnsiTerminal::set_color(u8 color) {
+    if (current_color == color) return;
+    out.append(PAIR_SGR[color < PAIR_SGR_COUNT ? color : 0]);
+    current_color = color;
+}
+
+bool_t AnsiTerminal::flush() {
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t n = write(fd, out.data() + done, out.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            out.clear();
+            return false;
+        }
+        done += (size_t)n;
+    }
+    out.clear();
+    return true;
+}
+
+u32 AnsiTerminal::present(const CellGrid& grid) {
+    u32 cells_sent = 0;
+    i32 height = grid.height() < rows ? grid.height() : rows;
+    i32 width = grid.width() < cols ? grid.width() : cols;
+
+    for (i32 y = 0; y < height; y++) {
+        Cell* row = &front[(size_t)y * cols];
+        for (i32 x = 0; x < width; x++) {
+            Cell cell = grid.at(y, x);
+            if (cell.ch == row[x].ch && cell.color == row[x].color) continue;
+
+            if (cursor_y == y && cursor_x <= x && x - cursor_x <= ANSI_GAP_MAX) {
+                // fill the short gap with what is already there if it needs no color change
+                for (i32 k = cursor_x; k < x; k++) {
+                    if (row[k].color != current_color) {
+                        move_to(y, x);
+                        break;
+                    }
+                }
+                for (; cursor_x < x; cursor_x++, cells_sent++) out.push_back((char)row[cursor_x].ch);
+            } else {
+                move_to(y, x);
+            }
+
+            set_color(cell.color);
+            out.push_back((char)cell.ch);
+            row[x] = cell;
+            cells_sent++;
+            // the terminal may defer the wrap after the last column, so stop trusting the cursor
+            cursor_x = x + 1;
+            if (cursor_x >= cols) cursor_y = -1;
+        }
+    }
+
+    flush();
+    return cells_sent;
+}
@@ -0,0 +1,47 @@
+#ifndef ANSI_TERMINAL_H
+#define ANSI_TERMINAL_H
+
+#include "custom_datatypes.h"
+#include "grid_printer.h"
+#include <termios.h>
+#include <string>
+#include <vector>
+
+// Presents a CellGrid with plain ANSI escape sequences instead of ncurses: the grid is
+// diffed against what this terminal was last sent, cursor moves and color changes are
+// emitted only when needed, and the whole frame leaves in one write().
+class AnsiTerminal {
+public:
+    AnsiTerminal();
+    ~AnsiTerminal();
+
+    // take over fd: raw mode if it is a tty, alternate screen, hidden cursor
+    bool_t open(i32 fd);
+
+    // restore the terminal; also done by the destructor
+    void close();
+
+    // size of the grids that will be presented (the next present repaints everything)
+    void resize(i32 rows, i32 cols);
+
+    // returns the number of cells sent
+    u32 present(const CellGrid& grid);
+
+private:
+    void move_to(i32 y, i32 x);
+    void set_color(u8 color);
+    bool_t flush();
+
+    i32 fd;
+    bool_t raw;
+    struct termios saved;
+    i32 rows;
+    i32 cols;
+    std::vector<Cell> front;
+    std::string out;
+    i32 cursor_y;                   // -1 = unknown
+    i32 cursor_x;
+    i32 current_color;              // -1 = unknown
+};
+
+#endif // ANSI_TERMINAL_H
@@ -0,0 +1,190 @@
+#include "event_loop.h"
+#include <ncurses.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <algorithm>
+
+// std heaps are max-heaps, so order by the later deadline
+bool_t EventLoop::later(const Deadline& a, const Deadline& b) {
+    return a.deadline > b.deadline;
+}
+
+EventLoop::EventLoop() : timer_fd(-1), signal_fd(-1), running(false), input_open(true), next_id(1) {}
+
+EventLoop::~EventLoop() {
+    if (timer_fd >= 0) close(timer_fd);
+    if (signal_fd >= 0) {
+        close(signal_fd);
+        sigset_t mask;
+        sigemptyset(&mask);
+        for (auto& entry : signals) sigaddset(&mask, entry.first);
+        sigprocmask(SIG_UNBLOCK, &mask, NULL);
+    }
+}
+
+bool_t EventLoop::init() {
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    return timer_fd >= 0;
+}
+
+u64 EventLoop::now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000 + (u64)ts.tv_nsec / 1000000;
+}
+
+u32 EventLoop::add_timer(u32 delay_ms, u32 interval_ms, TimerCallback cb) {
+    u32 id = next_id++;
+    Timer timer;
+    timer.deadline = now_ms() + delay_ms;
+    timer.interval = interval_ms;
+    timer.callback = cb;
+    timers[id] = timer;
+
+    Deadline entry = { timer.deadline, id };
+    queue.push_back(entry);
+    std::push_heap(queue.begin(), queue.end(), later);
+    return id;
+}
+
+void EventLoop::cancel_timer(u32 id) {
+    timers.erase(id);
+}
+
+bool_t EventLoop::watch_signal(i32 signo, SignalCallback cb) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (auto& entry : signals) sigaddset(&mask, entry.first);
+    sigaddset(&mask, signo);
+
+    // blocked signals stay pending until the signalfd reads them
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) != 0) return false;
+    i32 fd = signalfd(signal_fd, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) return false;
+    signal_fd = fd;
+    signals[signo] = cb;
+    return true;
+}
+
+void EventLoop::on_key(KeyCallback cb) {
+    key_callback = cb;
+}
+
+void EventLoop::stop() {
+    running = false;
+}
+
+// one timerfd serves every timer: it is set to the earliest live deadline
+void EventLoop::arm_timerfd() {
+    while (!queue.empty()) {
+        auto found = timers.find(queue.front().id);
+        if (found != timers.end() && found->second.deadline == queue.front().deadline) break;
+        std::pop_heap(queue.begin(), queue.end(), later);
+        queue.pop_back();
+    }
+
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (!queue.empty()) {
+        u64 deadline = queue.front().deadline;
+        // an all-zero value disarms the timer, so a deadline at 0 ms still needs a nanosecond
+        spec.it_value.tv_sec = (time_t)(deadline / 1000);
+        spec.it_value.tv_nsec = (long)(deadline % 1000) * 1000000 + 1;
+    }
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+}
+
+void EventLoop::fire_due_timers() {
+    u64 expirations;
+    while (read(timer_fd, &expirations, sizeof(expirations)) > 0) {}
+
+    u64 now = now_ms();
+    while (running && !queue.empty() && queue.front().deadline <= now) {
+        Deadline due = queue.front();
+        std::pop_heap(queue.begin(), queue.end(), later);
+        queue.pop_back();
+
+        auto found = timers.find(due.id);
+        if (found == timers.end() || found->second.deadline != due.deadline) continue;
+
+        // copy first: the callback may add or cancel timers and rehash the map
+        TimerCallback callback = found->second.callback;
+        if (found->second.interval == 0) {
+            timers.erase(found);
+        } else {
+            // stay on the original schedule, but skip ticks missed while busy
+            u64 next = due.deadline + found->second.interval;
+            if (next <= now) next = now + found->second.interval;
+            found->second.deadline = next;
+            Deadline entry = { next, due.id };
+            queue.push_back(entry);
+            std::push_heap(queue.begin(), queue.end(), later);
+        }
+        callback();
+    }
+}
+
+void EventLoop::read_signals() {
+    struct signalfd_siginfo info;
+    while (read(signal_fd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+        auto found = signals.find((i32)info.ssi_signo);
+        if (found != signals.end()) found->second((i32)info.ssi_signo);
+    }
+}
+
+// returns false at end of input: poll() reported stdin readable, yet there was no key
+// and nothing left to read (a closed pipe or /dev/null keeps polling readable forever)
+bool_t EventLoop::read_keys() {
+    // poll() said input is waiting, take everything ncurses can decode without blocking
+    nodelay(stdscr, TRUE);
+    i32 key = getch();
+    if (key == ERR) {
+        i32 pending = 0;
+        return ioctl(STDIN_FILENO, FIONREAD, &pending) == 0 && pending > 0;
+    }
+    do {
+        if (key_callback) key_callback(key);
+    } while (running && (key = getch()) != ERR);
+    return true;
+}
+
+void EventLoop::run() {
+    running = true;
+    while (running) {
+        arm_timerfd();
+
+        // a negative fd is ignored by poll()
+        struct pollfd fds[3];
+        fds[0].fd = key_callback && input_open ? STDIN_FILENO : -1;
+        fds[1].fd = timer_fd;
+        fds[2].fd = signal_fd;
+        for (i32 i = 0; i < 3; i++) {
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+
+        if (poll(fds, 3, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        if (fds[2].revents & POLLIN) read_signals();
+        if (fds[1].revents & POLLIN) fire_due_timers();
+        // at end of input stdin is dropped from the poll set rather than ending the loop,
+        // so timers and signals keep running; the key callback gets ERR to decide
+        if ((fds[0].revents & POLLIN) && !read_keys()) {
+            input_open = false;
+            if (key_callback) key_callback(ERR);
+        }
+        // the terminal went away, nothing can be shown or typed any more
+        if (fds[0].revents & (POLLHUP | POLLERR | POLLNVAL)) running = false;
+    }
+    running = false;
+}
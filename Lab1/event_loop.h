@@ -0,0 +1,71 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include "custom_datatypes.h"
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+typedef std::function<void()> TimerCallback;
+typedef std::function<void(i32 key)> KeyCallback;
+typedef std::function<void(i32 signo)> SignalCallback;
+
+// Single-threaded event loop: one poll() over the keyboard, a timerfd armed for the
+// earliest pending timer and a signalfd for the watched signals. Nothing runs between
+// events, so a waiting program sits at 0% CPU. Keys are read through ncurses getch().
+class EventLoop {
+public:
+    EventLoop();
+    ~EventLoop();
+
+    // create the timerfd, call before anything else
+    bool_t init();
+
+    // call cb after delay_ms, then every interval_ms unless that is 0; returns an id for cancel_timer
+    u32 add_timer(u32 delay_ms, u32 interval_ms, TimerCallback cb);
+    void cancel_timer(u32 id);
+
+    // deliver signo through the loop instead of a handler (it is blocked for the process)
+    bool_t watch_signal(i32 signo, SignalCallback cb);
+
+    // every key getch() returns, then ERR once if stdin reaches end of input;
+    // stdin is only polled while this is set and input is still open
+    void on_key(KeyCallback cb);
+
+    // dispatch events until stop() is called or stdin closes
+    void run();
+    void stop();
+
+    // CLOCK_MONOTONIC in milliseconds
+    static u64 now_ms();
+
+private:
+    typedef struct {
+        u64 deadline;
+        u32 id;
+    } Deadline;
+
+    typedef struct {
+        u64 deadline;
+        u32 interval;
+        TimerCallback callback;
+    } Timer;
+
+    static bool_t later(const Deadline& a, const Deadline& b);
+    void arm_timerfd();
+    void fire_due_timers();
+    void read_signals();
+    bool_t read_keys();
+
+    i32 timer_fd;
+    i32 signal_fd;
+    bool_t running;
+    bool_t input_open;
+    u32 next_id;
+    std::vector<Deadline> queue;            // min-heap on deadline, cancelled ids are skipped
+    std::unordered_map<u32, Timer> timers;
+    std::unordered_map<i32, SignalCallback> signals;
+    KeyCallback key_callback;
+};
+
+#endif // EVENT_LOOP_H
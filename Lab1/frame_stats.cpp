@@ -0,0 +1,144 @@
+#include "frame_stats.h"
+#include "grid_printer.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+static u64 now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+FrameRing::FrameRing() : head(0) {
+    for (u32 i = 0; i < FRAME_RING_SIZE; i++) slots[i].seq.store(0, std::memory_order_relaxed);
+}
+
+void FrameRing::push(const FrameSample& sample) {
+    u64 index = head.load(std::memory_order_relaxed);
+    Slot& slot = slots[index & (FRAME_RING_SIZE - 1)];
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.sample = sample;
+    slot.seq.store(2 * index + 2, std::memory_order_release);
+    head.store(index + 1, std::memory_order_release);
+}
+
+u32 FrameRing::snapshot(FrameSample* out, u32 max) const {
+    u64 end = head.load(std::memory_order_acquire);
+    if (max > FRAME_RING_SIZE) max = FRAME_RING_SIZE;
+    u64 begin = end > max ? end - max : 0;
+
+    u32 count = 0;
+    for (u64 index = begin; index < end; index++) {
+        const Slot& slot = slots[index & (FRAME_RING_SIZE - 1)];
+        u64 before = slot.seq.load(std::memory_order_acquire);
+        FrameSample sample = slot.sample;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        u64 after = slot.seq.load(std::memory_order_relaxed);
+        // overwritten by a newer frame while copying: drop it rather than return a torn sample
+        if (before != 2 * index + 2 || after != before) continue;
+        out[count++] = sample;
+    }
+    return count;
+}
+
+FrameStats::FrameStats() : frame_start(0), build_end(0), bytes_at_start(0) {
+    io_fd = open("/proc/self/io", O_RDONLY | O_CLOEXEC);
+}
+
+FrameStats::~FrameStats() {
+    if (io_fd >= 0) close(io_fd);
+}
+
+u64 FrameStats::bytes_written() const {
+    if (io_fd < 0) return 0;
+    char text[512];
+    ssize_t n = pread(io_fd, text, sizeof(text) - 1, 0);
+    if (n <= 0) return 0;
+    text[n] = '\0';
+    // counts every write() of the process, the terminal output is all of it while a frame is drawn
+    const char* field = strstr(text, "wchar: ");
+    return field != NULL ? strtoull(field + 7, NULL, 10) : 0;
+}
+
+void FrameStats::begin_frame() {
+    // read before the clock starts, so the proc read is not part of the frame time
+    bytes_at_start = bytes_written();
+    frame_start = now_ns();
+}
+
+void FrameStats::end_build() {
+    build_end = now_ns();
+}
+
+void FrameStats::end_frame(u32 cells) {
+    u64 end = now_ns();
+    u64 bytes = bytes_written();
+    FrameSample sample;
+    sample.start_ns = frame_start;
+    sample.build_ns = (u32)(build_end - frame_start);
+    sample.present_ns = (u32)(end - build_end);
+    sample.bytes = (u32)(bytes - bytes_at_start);
+    sample.cells = cells;
+    frames.push(sample);
+}
+
+FrameSummary FrameStats::summary(u32 window) const {
+    FrameSummary result;
+    memset(&result, 0, sizeof(result));
+
+    std::vector<FrameSample> samples(std::min<u32>(window, FRAME_RING_SIZE));
+    u32 count = frames.snapshot(samples.data(), (u32)samples.size());
+    if (count == 0) return result;
+
+    std::vector<u64> times(count);
+    u64 bytes = 0;
+    u64 now = now_ns();
+    u32 last_second = 0;
+    for (u32 i = 0; i < count; i++) {
+        times[i] = (u64)samples[i].build_ns + samples[i].present_ns;
+        bytes += samples[i].bytes;
+        if (now - samples[i].start_ns <= 1000000000ull) last_second++;
+    }
+
+    std::sort(times.begin(), times.end());
+    result.frames = count;
+    result.p50_ms = times[(count - 1) / 2] / 1e6;
+    result.p99_ms = times[(u64)(count - 1) * 99 / 100] / 1e6;
+    result.fps = last_second;
+    result.bytes_per_frame = (double)bytes / count;
+    return result;
+}
+
+void FrameStats::draw_overlay(CellGrid* grid) const {
+    FrameSummary s = summary();
+    char text[96];
+    snprintf(text, sizeof(text), " p50 %.3f ms  p99 %.3f ms  %.0f fps  %.0f B/frame ",
+             s.p50_ms, s.p99_ms, s.fps, s.bytes_per_frame);
+    i32 x = grid->width() - 2 - (i32)strlen(text);
+    grid->print(0, x > 1 ? x : 1, text, 5);
+}
+
+bool_t FrameStats::write_csv(const char* path) const {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) return false;
+
+    std::vector<FrameSample> samples(FRAME_RING_SIZE);
+    u32 count = frames.snapshot(samples.data(), FRAME_RING_SIZE);
+    u64 first = count > 0 ? samples[0].start_ns : 0;
+    u64 skipped = frames.pushed() - count;
+
+    fprintf(file, "frame,start_ms,build_us,present_us,bytes,cells\n");
+    for (u32 i = 0; i < count; i++) {
+        fprintf(file, "%llu,%.3f,%.1f,%.1f,%u,%u\n", (unsigned long long)(skipped + i),
+                (samples[i].start_ns - first) / 1e6, samples[i].build_ns / 1e3,
+                samples[i].present_ns / 1e3, samples[i].bytes, samples[i].cells);
+    }
+    return fclose(file) == 0;
+}
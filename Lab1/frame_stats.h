@@ -0,0 +1,89 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include "custom_datatypes.h"
+#include <atomic>
+
+class CellGrid;
+
+// one presented frame
+typedef struct {
+    u64 start_ns;                   // CLOCK_MONOTONIC when drawing began
+    u32 build_ns;                   // drawing into the back buffer
+    u32 present_ns;                 // diff, ncurses refresh and the write to the terminal
+    u32 bytes;                      // bytes the terminal was sent
+    u32 cells;                      // cells present() pushed
+} FrameSample;
+
+// Must be a power of two. Older frames are overwritten, the CSV keeps the newest.
+#define FRAME_RING_SIZE 4096
+
+// frames the overlay percentiles are taken over
+#define FRAME_SUMMARY_WINDOW 256
+
+typedef struct {
+    u32 frames;                     // samples the figures below are taken from
+    double p50_ms;                  // build + present
+    double p99_ms;
+    double fps;                     // frames started during the last second
+    double bytes_per_frame;
+} FrameSummary;
+
+// Single-writer ring of frame samples. push() never blocks or allocates; any thread
+// may read concurrently, slots being rewritten meanwhile are skipped.
+class FrameRing {
+public:
+    FrameRing();
+
+    void push(const FrameSample& sample);
+
+    // copies up to max of the newest samples, oldest first, returns how many
+    u32 snapshot(FrameSample* out, u32 max) const;
+
+    u64 pushed() const { return head.load(std::memory_order_acquire); }
+
+private:
+    typedef struct {
+        std::atomic<u64> seq;       // 2 * index + 2 once written, odd while being written
+        FrameSample sample;
+    } Slot;
+
+    Slot slots[FRAME_RING_SIZE];
+    std::atomic<u64> head;
+};
+
+// Times the draw path and counts the bytes the process writes (ncurses writes the
+// screen straight to the terminal fd). Bracket every frame with begin_frame /
+// end_build / end_frame.
+class FrameStats {
+public:
+    FrameStats();
+    ~FrameStats();
+
+    void begin_frame();
+    void end_build();
+    void end_frame(u32 cells);
+
+    // over the newest window frames (at most FRAME_RING_SIZE)
+    FrameSummary summary(u32 window = FRAME_SUMMARY_WINDOW) const;
+
+    // p50/p99 frame time and FPS of the frames so far, on the top border
+    void draw_overlay(CellGrid* grid) const;
+
+    // every sample still in the ring, returns false if the file cannot be written
+    bool_t write_csv(const char* path) const;
+
+    const FrameRing& ring() const { return frames; }
+
+private:
+    // total bytes passed to write() so far, from /proc/self/io; 0 when unavailable
+    u64 bytes_written() const;
+
+    FrameRing frames;
+    i32 io_fd;
+    u64 frame_start;
+    u64 build_end;
+    u64 bytes_at_start;
+};
+
+#endif // FRAME_STATS_H
@@ -0,0 +1,209 @@
+#include "grid_bench.h"
+#include "grid_printer.h"
+#include "ansi_terminal.h"
+#include "frame_stats.h"
+#include <ncurses.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <thread>
+
+static const char* BACKEND_NAMES[BACKEND_COUNT] = { "ncurses", "ansi" };
+static const char* WORKLOAD_NAMES[WORKLOAD_COUNT] = { "noise", "scroll", "sparse" };
+
+static const char* WORDS[] = {
+    "grid", "frame", "cell", "terminal", "escape", "cursor", "color", "refresh",
+    "buffer", "scroll", "noise", "write", "present", "row", "column", "pty",
+};
+#define WORD_COUNT (sizeof(WORDS) / sizeof(WORDS[0]))
+
+// the fd the backend draws to, and for a pty the thread playing the terminal
+typedef struct {
+    i32 fd;
+    i32 master;
+    std::thread drain;
+} BenchOutput;
+
+static u32 next_random(u32* state) {
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static u64 now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+static bool_t open_output(const BenchOptions* options, BenchOutput* output) {
+    output->master = -1;
+    if (options->target == TARGET_NULL) {
+        output->fd = open("/dev/null", O_RDWR | O_CLOEXEC);
+        return output->fd >= 0;
+    }
+
+    output->master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (output->master < 0 || grantpt(output->master) != 0 || unlockpt(output->master) != 0) {
+        if (output->master >= 0) close(output->master);
+        return false;
+    }
+    output->fd = open(ptsname(output->master), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (output->fd < 0) {
+        close(output->master);
+        return false;
+    }
+    struct winsize size;
+    memset(&size, 0, sizeof(size));
+    size.ws_row = (u16)options->rows;
+    size.ws_col = (u16)options->cols;
+    ioctl(output->fd, TIOCSWINSZ, &size);
+
+    // read and discard like a very fast terminal, so writes never stall on a full pty
+    i32 master = output->master;
+    output->drain = std::thread([master]() {
+        char buffer[64 * 1024];
+        while (read(master, buffer, sizeof(buffer)) > 0) {}
+    });
+    return true;
+}
+
+static void close_output(BenchOutput* output) {
+    close(output->fd);
+    // with the slave closed the master read fails with EIO and the drain thread ends
+    if (output->drain.joinable()) output->drain.join();
+    if (output->master >= 0) close(output->master);
+}
+
+// text line number `line` of an endless log, the same every time it is drawn
+static void draw_line(CellGrid* grid, i32 y, u32 line) {
+    u32 rng = line * 2654435761u + 1;
+    u8 color = (u8)(next_random(&rng) % 6);
+    i32 x = 1;
+    while (x < grid->width()) {
+        const char* word = WORDS[next_random(&rng) % WORD_COUNT];
+        grid->print(y, x, word, color);
+        x += (i32)strlen(word) + 1;
+    }
+}
+
+static void draw_workload(CellGrid* grid, BenchWorkload workload, u32 frame, u32* rng) {
+    i32 rows = grid->height();
+    i32 cols = grid->width();
+
+    if (workload == WORKLOAD_NOISE) {
+        for (i32 y = 0; y < rows; y++) {
+            for (i32 x = 0; x < cols; x++) {
+                u32 r = next_random(rng);
+                grid->put(y, x, (char)('!' + r % 94), (u8)((r >> 8) % 6));
+            }
+        }
+    } else if (workload == WORKLOAD_SCROLL) {
+        grid->blank();
+        for (i32 y = 0; y < rows; y++) draw_line(grid, y, frame + (u32)y);
+    } else {
+        u32 changes = (u32)rows * (u32)cols / 100 + 1;
+        for (u32 i = 0; i < changes; i++) {
+            u32 r = next_random(rng);
+            i32 y = (i32)(next_random(rng) % (u32)rows);
+            i32 x = (i32)(next_random(rng) % (u32)cols);
+            grid->put(y, x, (char)('!' + r % 94), (u8)((r >> 8) % 6));
+        }
+    }
+}
+
+bool_t bench_run(BenchBackend backend, BenchWorkload workload, const BenchOptions* options, BenchResult* result) {
+    memset(result, 0, sizeof(*result));
+    if (options->rows <= 0 || options->cols <= 0) return false;
+
+    BenchOutput output;
+    if (!open_output(options, &output)) return false;
+
+    SCREEN* screen = NULL;
+    FILE* out = NULL;
+    FILE* in = NULL;
+    AnsiTerminal ansi;
+    bool_t ready;
+    if (backend == BACKEND_NCURSES) {
+        const char* term = getenv("TERM");
+        if (term == NULL || term[0] == '\0' || strcmp(term, "dumb") == 0) term = "xterm";
+        out = fdopen(dup(output.fd), "w");
+        in = fdopen(dup(output.fd), "r");
+        if (out != NULL && in != NULL) screen = newterm(term, out, in);
+        ready = screen != NULL;
+        if (ready) {
+            cbreak();
+            noecho();
+            curs_set(0);
+            setup_colors();
+            resizeterm(options->rows, options->cols);
+        }
+    } else {
+        ready = ansi.open(output.fd);
+        ansi.resize(options->rows, options->cols);
+    }
+
+    if (ready) {
+        CellGrid grid;
+        grid.resize(options->rows, options->cols);
+        FrameStats* stats = new FrameStats;
+        u32 rng = options->seed != 0 ? options->seed : 1;
+
+        u64 start = now_ns();
+        for (u32 frame = 0; frame < options->frames; frame++) {
+            stats->begin_frame();
+            draw_workload(&grid, workload, frame, &rng);
+            stats->end_build();
+            u32 cells = backend == BACKEND_NCURSES ? grid.present() : ansi.present(grid);
+            stats->end_frame(cells);
+        }
+        u64 elapsed = now_ns() - start;
+
+        FrameSummary summary = stats->summary(options->frames);
+        result->frames = options->frames;
+        result->seconds = elapsed / 1e9;
+        result->fps = elapsed > 0 ? options->frames / result->seconds : 0;
+        result->bytes_per_frame = summary.bytes_per_frame;
+        result->p50_ms = summary.p50_ms;
+        result->p99_ms = summary.p99_ms;
+        delete stats;
+    }
+
+    if (screen != NULL) {
+        endwin();
+        delscreen(screen);
+    }
+    if (out != NULL) fclose(out);
+    if (in != NULL) fclose(in);
+    ansi.close();
+    close_output(&output);
+    return ready;
+}
+
+i32 run_grid_bench(const BenchOptions* options) {
+    printf("%u frames of %dx%d per run, written to %s\n", options->frames, options->rows, options->cols,
+           options->target == TARGET_NULL ? "/dev/null" : "a drained pty");
+    printf("%-8s %-8s %10s %12s %9s %9s\n", "workload", "backend", "frames/s", "bytes/frame", "p50 ms", "p99 ms");
+
+    i32 status = 0;
+    for (i32 workload = 0; workload < WORKLOAD_COUNT; workload++) {
+        for (i32 backend = 0; backend < BACKEND_COUNT; backend++) {
+            BenchResult result;
+            if (!bench_run((BenchBackend)backend, (BenchWorkload)workload, options, &result)) {
+                printf("%-8s %-8s %s\n", WORKLOAD_NAMES[workload], BACKEND_NAMES[backend], "could not open the output");
+                status = 1;
+                continue;
+            }
+            printf("%-8s %-8s %10.1f %12.1f %9.3f %9.3f\n", WORKLOAD_NAMES[workload], BACKEND_NAMES[backend],
+                   result.fps, result.bytes_per_frame, result.p50_ms, result.p99_ms);
+        }
+    }
+    return status;
+}
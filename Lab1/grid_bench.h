@@ -0,0 +1,47 @@
+#ifndef GRID_BENCH_H
+#define GRID_BENCH_H
+
+#include "custom_datatypes.h"
+
+typedef enum {
+    BACKEND_NCURSES,                // CellGrid::present() through ncurses
+    BACKEND_ANSI,                   // AnsiTerminal
+    BACKEND_COUNT
+} BenchBackend;
+
+typedef enum {
+    WORKLOAD_NOISE,                 // every cell random each frame
+    WORKLOAD_SCROLL,                // text moving up one line per frame
+    WORKLOAD_SPARSE,                // about 1% of the cells change per frame
+    WORKLOAD_COUNT
+} BenchWorkload;
+
+typedef enum {
+    TARGET_NULL,                    // /dev/null: encoding cost only
+    TARGET_PTY                      // a pty whose other end is drained: adds the tty layer
+} BenchTarget;
+
+typedef struct {
+    u32 frames;                     // per workload and backend
+    i32 rows;
+    i32 cols;
+    BenchTarget target;
+    u32 seed;
+} BenchOptions;
+
+typedef struct {
+    u32 frames;
+    double seconds;
+    double fps;
+    double bytes_per_frame;
+    double p50_ms;                  // build + present
+    double p99_ms;
+} BenchResult;
+
+// one workload on one backend, headless; false if the target could not be set up
+bool_t bench_run(BenchBackend backend, BenchWorkload workload, const BenchOptions* options, BenchResult* result);
+
+// every workload on every backend, one line each on stdout
+i32 run_grid_bench(const BenchOptions* options);
+
+#endif // GRID_BENCH_H
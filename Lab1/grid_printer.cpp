@@ -1,7 +1,146 @@
 #include "grid_printer.h"
+#include "event_loop.h"
+#include "frame_stats.h"
 #include <ncurses.h>
-#include <thread>
-#include <chrono>
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <algorithm>
+
+static inline bool_t same_cell(Cell a, Cell b) {
+    return a.ch == b.ch && a.color == b.color;
+}
+
+CellGrid::CellGrid() : rows(0), cols(0), current_color(-1) {}
+
+void CellGrid::resize(i32 new_rows, i32 new_cols) {
+    rows = new_rows > 0 ? new_rows : 0;
+    cols = new_cols > 0 ? new_cols : 0;
+    Cell empty = { ' ', 0 };
+    back.assign((size_t)rows * cols, empty);
+    front.assign((size_t)rows * cols, empty);
+    sent.assign((size_t)rows * cols, 0);
+    invalidate();
+}
+
+void CellGrid::blank() {
+    Cell empty = { ' ', 0 };
+    back.assign(back.size(), empty);
+}
+
+void CellGrid::invalidate() {
+    // a value no drawing produces, so every cell counts as changed
+    Cell unknown = { 0, 0xFF };
+    front.assign(front.size(), unknown);
+    current_color = -1;
+}
+
+void CellGrid::put(i32 y, i32 x, char ch, u8 color) {
+    if (!in_bounds(y, x)) return;
+    Cell cell = { (u8)ch, color };
+    back[(size_t)y * cols + x] = cell;
+}
+
+void CellGrid::print(i32 y, i32 x, const char* text, u8 color) {
+    for (; *text != '\0'; text++, x++) put(y, x, *text, color);
+}
+
+void CellGrid::hfill(i32 y, i32 x, char ch, i32 len, u8 color) {
+    for (i32 i = 0; i < len; i++) put(y, x + i, ch, color);
+}
+
+void CellGrid::vfill(i32 y, i32 x, char ch, i32 len, u8 color) {
+    for (i32 i = 0; i < len; i++) put(y + i, x, ch, color);
+}
+
+void CellGrid::set_color(u8 color) {
+    if (current_color == color) return;
+    attrset(color != 0 ? COLOR_PAIR(color) : A_NORMAL);
+    current_color = color;
+}
+
+u32 CellGrid::present() {
+    u32 cells_sent = 0;
+    std::fill(sent.begin(), sent.end(), 0);
+
+    // vertical runs first (frame sides, columns of text), one mvvline each
+    for (i32 x = 0; x < cols; x++) {
+        i32 y = 0;
+        while (y < rows) {
+            size_t at = (size_t)y * cols + x;
+            if (same_cell(back[at], front[at])) {
+                y++;
+                continue;
+            }
+            i32 len = 1;
+            while (y + len < rows) {
+                size_t next = (size_t)(y + len) * cols + x;
+                if (same_cell(back[next], front[next]) || !same_cell(back[next], back[at])) break;
+                len++;
+            }
+            if (len >= LINE_RUN_MIN) {
+                set_color(back[at].color);
+                mvvline(y, x, back[at].ch, len);
+                for (i32 k = 0; k < len; k++) sent[(size_t)(y + k) * cols + x] = 1;
+                cells_sent += len;
+            }
+            y += len;
+        }
+    }
+
+    // then each row: runs of one cell as mvhline, the rest as text spans of one color
+    std::string span;
+    for (i32 y = 0; y < rows; y++) {
+        const Cell* row = &back[(size_t)y * cols];
+        i32 x = 0;
+        while (x < cols) {
+            size_t at = (size_t)y * cols + x;
+            if (sent[at] || same_cell(row[x], front[at])) {
+                x++;
+                continue;
+            }
+
+            i32 len = 1;
+            while (x + len < cols && !sent[at + len] && same_cell(row[x + len], row[x])) len++;
+            if (len >= LINE_RUN_MIN) {
+                set_color(row[x].color);
+                mvhline(y, x, row[x].ch, len);
+                cells_sent += len;
+                x += len;
+                continue;
+            }
+
+            // a text span: changed cells of the same color, stopping before a long run
+            u8 color = row[x].color;
+            span.clear();
+            i32 end = x;
+            while (end < cols && !sent[at + (end - x)] && row[end].color == color) {
+                size_t here = (size_t)y * cols + end;
+                if (same_cell(row[end], front[here])) {
+                    // short unchanged gaps are cheaper to resend than to move the cursor over
+                    i32 gap = 1;
+                    while (end + gap < cols && gap < LINE_RUN_MIN && same_cell(row[end + gap], front[here + gap])) gap++;
+                    if (gap >= LINE_RUN_MIN || end + gap >= cols || row[end + gap].color != color) break;
+                }
+                i32 run = 1;
+                while (end + run < cols && run < LINE_RUN_MIN && same_cell(row[end + run], row[end])) run++;
+                if (run >= LINE_RUN_MIN && end > x) break;
+                span.push_back((char)row[end].ch);
+                end++;
+            }
+            set_color(color);
+            mvaddnstr(y, x, span.c_str(), (int)span.size());
+            cells_sent += (u32)span.size();
+            x = end;
+        }
+    }
+
+    front = back;
+    set_color(0);
+    refresh();
+    return cells_sent;
+}
 
 void init_ncurses() {
     initscr();
@@ -28,74 +167,124 @@ void gotoxy(i32 y, i32 x) {
     move(y, x);
 }
 
-void draw_frame() {
-    int max_y, max_x;
-    getmaxyx(stdscr, max_y, max_x);
+void draw_frame(CellGrid* grid) {
+    i32 max_y = grid->height();
+    i32 max_x = grid->width();
 
-    for (int i = 0; i < max_x; ++i) {
-        mvprintw(0, i, "-");
-        mvprintw(max_y - 1, i, "-");
-    }
+    grid->hfill(0, 0, '-', max_x);
+    grid->hfill(max_y - 1, 0, '-', max_x);
+    grid->vfill(0, 0, '|', max_y);
+    grid->vfill(0, max_x - 1, '|', max_y);
+}
+
+// everything on screen is derived from this, so a resize can redraw it from scratch
+typedef struct {
+    CellGrid grid;
+    FrameStats stats;
+    bool_t overlay;
+    bool_t input_closed;            // stdin hit end of input, no key will ever come
+    i32 phase;
+    i32 seconds_left;
+} PrinterState;
+
+static void draw_phase(PrinterState* state) {
+    CellGrid* grid = &state->grid;
+    grid->blank();
+    draw_frame(grid);
 
-    for (int i = 0; i < max_y; ++i) {
-        mvprintw(i, 0, "|");
-        mvprintw(i, max_x - 1, "|");
+    if (state->phase == 1) {
+        grid->print(2, 5, "--- Phase 1: Colorful Display ---");
+        grid->print(6, 10, "1. This phrase is RED.", 1);
+        grid->print(8, 10, "2. This phrase is GREEN.", 2);
+        grid->print(10, 10, "3. This phrase is BLUE.", 3);
+
+        char action[96];
+        snprintf(action, sizeof(action), "ACTION: wait (Screen will clear in %d seconds...)", state->seconds_left);
+        grid->print(20, 5, action, 5);
+    } else {
+        grid->print(2, 5, "--- Phase 2: After Screen Clear ---");
+        grid->print(6, 10, "Screen Cleared! New content in CYAN (Pair 4).", 4);
+        grid->print(8, 10, "The display was successfully refreshed.", 4);
+        grid->print(20, 5, "ACTION: wait (Press any key to restore terminal...)");
     }
 }
 
-i32 run_grid_printer(i32 sleep_duration_seconds) {
-    init_ncurses();
-    setup_colors();
+// one timed frame: drawing, then the diff and the write to the terminal
+static void render(PrinterState* state) {
+    state->stats.begin_frame();
+    draw_phase(state);
+    if (state->overlay) state->stats.draw_overlay(&state->grid);
+    state->stats.end_build();
+    u32 cells = state->grid.present();
+    state->stats.end_frame(cells);
+}
 
-    draw_frame();
-    gotoxy(2, 5);
-    printw("--- Phase 1: Colorful Display ---");
-
-    attron(COLOR_PAIR(1));
-    gotoxy(6, 10);
-    printw("1. This phrase is RED.");
-    attroff(COLOR_PAIR(1));
-
-    attron(COLOR_PAIR(2));
-    gotoxy(8, 10);
-    printw("2. This phrase is GREEN.");
-    attroff(COLOR_PAIR(2));
-
-    attron(COLOR_PAIR(3));
-    gotoxy(10, 10);
-    printw("3. This phrase is BLUE.");
-    attroff(COLOR_PAIR(3));
-
-    attron(COLOR_PAIR(5));
-    gotoxy(20, 5);
-    printw("ACTION: wait (Screen will clear in %d seconds...)", sleep_duration_seconds);
-    attroff(COLOR_PAIR(5));
-    
-    refresh();
+// SIGWINCH: pick up the new size, then repaint everything at it
+static void relayout(PrinterState* state) {
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0) resizeterm(size.ws_row, size.ws_col);
+    clearok(curscr, TRUE);
+    state->grid.resize(LINES, COLS);
+    render(state);
+}
 
-    std::this_thread::sleep_for(std::chrono::seconds(sleep_duration_seconds));
+i32 run_grid_printer(i32 sleep_duration_seconds, bool_t overlay, const char* csv_path) {
+    // signals must be blocked before ncurses installs its own SIGWINCH handler
+    EventLoop loop;
+    if (!loop.init()) {
+        perror("timerfd_create");
+        return 1;
+    }
+    PrinterState state;
+    loop.watch_signal(SIGWINCH, [&](i32) { relayout(&state); });
+    loop.watch_signal(SIGINT, [&](i32) { loop.stop(); });
+    loop.watch_signal(SIGTERM, [&](i32) { loop.stop(); });
 
-    clear();
-    
-    draw_frame();
-    gotoxy(2, 5);
-    printw("--- Phase 2: After Screen Clear ---");
+    init_ncurses();
+    setup_colors();
 
-    attron(COLOR_PAIR(4));
-    gotoxy(6, 10);
-    printw("Screen Cleared! New content in CYAN (Pair 4).");
-    gotoxy(8, 10);
-    printw("The display was successfully refreshed.");
-    attroff(COLOR_PAIR(4));
+    state.overlay = overlay;
+    state.input_closed = false;
+    state.phase = 1;
+    state.seconds_left = sleep_duration_seconds;
+    state.grid.resize(LINES, COLS);
+    render(&state);
 
-    gotoxy(20, 5);
-    printw("ACTION: wait (Press any key to restore terminal...)");
+    // the countdown only changes one digit, present() sends just that
+    u32 countdown = loop.add_timer(1000, 1000, [&]() {
+        if (state.seconds_left > 0) state.seconds_left--;
+        render(&state);
+    });
 
-    refresh();
+    // phase 2 is drawn from scratch, present() only sends what differs from phase 1
+    loop.add_timer((u32)sleep_duration_seconds * 1000, 0, [&]() {
+        loop.cancel_timer(countdown);
+        state.phase = 2;
+        render(&state);
+        // like the old blocking getch(), which returned ERR at once with no input left
+        if (state.input_closed) loop.stop();
+    });
+
+    // keys typed during phase 1 are read and dropped, only a key in phase 2 ends the program;
+    // ERR means stdin closed, phase 2 is still shown before the program ends
+    loop.on_key([&](i32 key) {
+        if (key == ERR) state.input_closed = true;
+        if (state.phase == 2) loop.stop();
+    });
 
-    getch();
+    loop.run();
 
     endwin();
 
+    if (csv_path != NULL) {
+        FrameSummary summary = state.stats.summary();
+        printf("%u frames: p50 %.3f ms, p99 %.3f ms, %.0f bytes/frame\n",
+               summary.frames, summary.p50_ms, summary.p99_ms, summary.bytes_per_frame);
+        if (!state.stats.write_csv(csv_path)) {
+            perror(csv_path);
+            return 1;
+        }
+    }
+
     return 0;
-}
\ No newline at end of file
+}
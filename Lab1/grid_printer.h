@@ -1,8 +1,62 @@
 #ifndef GRID_PRINTER_H
 #define GRID_PRINTER_H
 
-#include "custom_datatypes.h" 
+#include "custom_datatypes.h"
 #include <string>
+#include <vector>
+
+// one screen position: an ASCII character and a color pair (0 = default colors)
+typedef struct {
+    u8 ch;
+    u8 color;
+} Cell;
+
+// Minimum length of a run of identical cells that present() sends as a single
+// mvhline/mvvline instead of text.
+#define LINE_RUN_MIN 4
+
+// Double-buffered screen. Drawing only touches the back buffer; present() compares
+// it with the front buffer (what ncurses was last given) and pushes just the cells
+// that changed: vertical runs of one cell with mvvline, horizontal runs with mvhline,
+// everything else as text spans, switching attributes only when the color changes.
+class CellGrid {
+public:
+    CellGrid();
+
+    // match the buffers to the terminal size (contents are cleared)
+    void resize(i32 rows, i32 cols);
+
+    // blank the back buffer
+    void blank();
+
+    // make the next present() repaint every cell (after an external clear)
+    void invalidate();
+
+    void put(i32 y, i32 x, char ch, u8 color = 0);
+    void print(i32 y, i32 x, const char* text, u8 color = 0);
+    void hfill(i32 y, i32 x, char ch, i32 len, u8 color = 0);
+    void vfill(i32 y, i32 x, char ch, i32 len, u8 color = 0);
+
+    // send the changes to ncurses and refresh, returns the number of cells sent
+    u32 present();
+
+    // what the back buffer holds at y, x
+    Cell at(i32 y, i32 x) const { return back[(size_t)y * cols + x]; }
+
+    i32 height() const { return rows; }
+    i32 width() const { return cols; }
+
+private:
+    bool_t in_bounds(i32 y, i32 x) const { return y >= 0 && y < rows && x >= 0 && x < cols; }
+    void set_color(u8 color);
+
+    i32 rows;
+    i32 cols;
+    std::vector<Cell> back;
+    std::vector<Cell> front;
+    std::vector<u8> sent;           // per cell, already pushed during this present()
+    i32 current_color;              // attribute currently set in ncurses, -1 = unknown
+};
 
 void init_ncurses();
 
@@ -10,8 +64,9 @@ bool_t setup_colors();
 
 void gotoxy(i32 y, i32 x);
 
-void draw_frame();
+void draw_frame(CellGrid* grid);
 
-i32 run_grid_printer(i32 sleep_duration_seconds);
+// overlay: show frame times on the top border; csv_path: per-frame samples written on exit, or NULL
+i32 run_grid_printer(i32 sleep_duration_seconds, bool_t overlay = false, const char* csv_path = NULL);
 
-#endif // GRID_PRINTER_H
\ No newline at end of file
+#endif // GRID_PRINTER_H
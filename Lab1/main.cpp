@@ -1,6 +1,54 @@
 #include "grid_printer.h"
+#include "grid_bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-int main() {
+// usage: grid_printer [-o] [-c frames.csv]
+//        grid_printer -b [-n frames] [-g ROWSxCOLS] [-t null|pty]
+//   -o  show frame-time overlay
+//   -c  write per-frame timings to a CSV file on exit
+//   -b  headless benchmark of the ncurses and raw ANSI backends
+static void usage(const char* program) {
+    fprintf(stderr, "usage: %s [-o] [-c frames.csv]\n", program);
+    fprintf(stderr, "       %s -b [-n frames] [-g ROWSxCOLS] [-t null|pty]\n", program);
+}
+
+int main(int argc, char** argv) {
     i32 custom_sleep_time = 3;
-    return run_grid_printer(custom_sleep_time);
-}
\ No newline at end of file
+    bool_t overlay = false;
+    const char* csv_path = NULL;
+
+    bool_t bench = false;
+    BenchOptions options;
+    options.frames = 1000;
+    options.rows = 50;
+    options.cols = 160;
+    options.target = TARGET_NULL;
+    options.seed = 1;
+
+    for (i32 i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0) {
+            overlay = true;
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0) {
+            bench = true;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            options.frames = (u32)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &options.rows, &options.cols) != 2) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            options.target = strcmp(argv[++i], "pty") == 0 ? TARGET_PTY : TARGET_NULL;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (bench) return run_grid_bench(&options);
+    return run_grid_printer(custom_sleep_time, overlay, csv_path);
+}
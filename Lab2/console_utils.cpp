@@ -1,10 +1,15 @@
 #include "console_utils.h"
 
 #include <iostream>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <new>
 #include <string>
+#include <thread>
+#include <vector>
 
 #if defined(_WIN32) || defined(_WIN64)
 // ===================== Windows =====================
@@ -41,17 +46,78 @@ i32 get_key() {
         if (ch == 72) return KEY_UP;      // Up arrow
         if (ch == 80) return KEY_DOWN;    // Down arrow
         if (ch == 71) return KEY_HOME;    // Home
+        if (ch == 79) return KEY_END;     // End
+        if (ch == 73) return KEY_PGUP;    // Page Up
+        if (ch == 81) return KEY_PGDN;    // Page Down
+        if (ch == 75) return KEY_LEFT;    // Left arrow
+        if (ch == 77) return KEY_RIGHT;   // Right arrow
+        if (ch == 83) return KEY_DELETE;  // Delete
         return KEY_OTHER;
     }
 
+    if (ch == 27) return KEY_ESC;
+
     return ch;
 }
 
+// one buffered frame: anything std::cout still holds goes first
+static void write_frame(const std::string& out) {
+    std::cout.write(out.data(), (std::streamsize)out.size());
+    std::cout << std::flush;
+}
+
+i32 get_keys(KeyBatch* batch) {
+    // the console already delivers whole keys, so take what is queued behind the first
+    batch->count = 0;
+    batch->keys[batch->count++] = get_key();
+    while (batch->count < KEY_BATCH_MAX && _kbhit()) batch->keys[batch->count++] = get_key();
+    return batch->count;
+}
+
+bool_t key_waiting() {
+    return _kbhit() != 0;
+}
+
+// no mapping on Windows, the file is read into memory
+static bool_t map_file(const char* path, const char** data, size_t* size) {
+    FILE* file = std::fopen(path, "rb");
+    if (!file) return 0;
+    std::fseek(file, 0, SEEK_END);
+    long length = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    char* buffer = length > 0 ? (char*)std::malloc((size_t)length) : NULL;
+    bool_t ok = length == 0 || (buffer && std::fread(buffer, 1, (size_t)length, file) == (size_t)length);
+    std::fclose(file);
+    if (!ok) {
+        std::free(buffer);
+        return 0;
+    }
+    *data = buffer;
+    *size = (size_t)length;
+    return 1;
+}
+
+static void unmap_file(const char* data, size_t size) {
+    (void)size;
+    std::free((void*)data);
+}
+
+// background work: let the input thread have the CPU first
+static void lower_thread_priority() {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+}
+
 #else
 // ===================== Linux / macOS =====================
 
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <termios.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 
 static struct termios old_term;
 
@@ -66,37 +132,256 @@ void start_console() {
     t.c_cc[VTIME] = 0;
 
     tcsetattr(STDIN_FILENO, TCSANOW, &t);
+
+    // bracketed paste: pasted text arrives between ESC [ 200 ~ and ESC [ 201 ~
+    std::cout << "\033[?2004h" << std::flush;
 }
 
 void stop_console() {
+    std::cout << "\033[?2004l" << std::flush;
     tcsetattr(STDIN_FILENO, TCSANOW, &old_term);
 }
 
-i32 get_key() {
-    int ch = getchar();
-
-    // ESC sequence for arrows / home
-    if (ch == 0x1B) {          // ESC
-        int seq1 = getchar();
-        if (seq1 == '[') {
-            int seq2 = getchar();
-            if (seq2 == 'A') return KEY_UP;    // Up
-            if (seq2 == 'B') return KEY_DOWN;  // Down
-            if (seq2 == 'H') return KEY_HOME;  // Home (ESC [ H)
-
-            // Some terminals send ESC [ 1 ~ for Home
-            if (seq2 == '1') {
-                int seq3 = getchar();
-                if (seq3 == '~') return KEY_HOME;
+// one buffered frame in a single write(): anything std::cout still holds goes first
+static void write_frame(const std::string& out) {
+    std::cout << std::flush;
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t n = write(STDOUT_FILENO, out.data() + done, out.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        done += (size_t)n;
+    }
+}
+
+// ---------- Input decoder ----------
+// Every byte is classified, and (state, class) picks an action and the next state
+// from DECODE_TABLE. Completed sequences are looked up in ESCAPE_KEYS.
+
+enum { ST_GROUND, ST_ESC, ST_CSI, ST_SS3, ST_COUNT };
+enum { CL_ESC, CL_BRACKET, CL_O, CL_PARAM, CL_FINAL, CL_OTHER, CL_COUNT };
+enum { ACT_EMIT, ACT_START, ACT_COLLECT, ACT_DISPATCH, ACT_ALT, ACT_ABORT };
+
+typedef struct {
+    u8 action;
+    u8 next;
+} Transition;
+
+static const Transition DECODE_TABLE[ST_COUNT][CL_COUNT] = {
+    //              ESC                      [                         O                         param 0x20-0x3F           final 0x40-0x7E            other
+    /* GROUND */ { {ACT_START, ST_ESC},  {ACT_EMIT, ST_GROUND},    {ACT_EMIT, ST_GROUND},    {ACT_EMIT, ST_GROUND},    {ACT_EMIT, ST_GROUND},     {ACT_EMIT, ST_GROUND} },
+    /* ESC    */ { {ACT_ALT, ST_GROUND}, {ACT_COLLECT, ST_CSI},    {ACT_COLLECT, ST_SS3},    {ACT_ALT, ST_GROUND},     {ACT_ALT, ST_GROUND},      {ACT_ALT, ST_GROUND} },
+    /* CSI    */ { {ACT_ABORT, ST_GROUND}, {ACT_DISPATCH, ST_GROUND}, {ACT_DISPATCH, ST_GROUND}, {ACT_COLLECT, ST_CSI}, {ACT_DISPATCH, ST_GROUND}, {ACT_ABORT, ST_GROUND} },
+    /* SS3    */ { {ACT_ABORT, ST_GROUND}, {ACT_DISPATCH, ST_GROUND}, {ACT_DISPATCH, ST_GROUND}, {ACT_ABORT, ST_GROUND}, {ACT_DISPATCH, ST_GROUND}, {ACT_ABORT, ST_GROUND} },
+};
+
+typedef struct {
+    const char* seq;    // what follows ESC
+    i32 key;
+} EscapeKey;
+
+static const EscapeKey ESCAPE_KEYS[] = {
+    {"[A", KEY_UP},    {"[B", KEY_DOWN},  {"[C", KEY_RIGHT}, {"[D", KEY_LEFT},
+    {"OA", KEY_UP},    {"OB", KEY_DOWN},  {"OC", KEY_RIGHT}, {"OD", KEY_LEFT},
+    {"[H", KEY_HOME},  {"OH", KEY_HOME},  {"[1~", KEY_HOME}, {"[7~", KEY_HOME},
+    {"[F", KEY_END},   {"OF", KEY_END},   {"[4~", KEY_END},  {"[8~", KEY_END},
+    {"[5~", KEY_PGUP}, {"[6~", KEY_PGDN}, {"[3~", KEY_DELETE},
+    {"[200~", KEY_PASTE_BEGIN}, {"[201~", KEY_PASTE_END},
+};
+
+#define ESCAPE_SEQ_MAX 16
+
+typedef struct {
+    u8   buf[INPUT_BUF_BYTES];  // bytes read but not decoded yet
+    i32  pos;
+    i32  len;
+    i32  state;
+    char seq[ESCAPE_SEQ_MAX];   // the sequence collected since ESC
+    i32  seq_len;
+    bool_t paste;               // between KEY_PASTE_BEGIN and KEY_PASTE_END
+} InputDecoder;
+
+static InputDecoder input;
+
+// keys decoded by get_keys() but not yet returned by get_key()
+static KeyBatch pending;
+static i32 pending_pos = 0;
+
+static i32 classify(u8 ch) {
+    if (ch == 0x1B) return CL_ESC;
+    if (ch == '[')  return CL_BRACKET;
+    if (ch == 'O')  return CL_O;
+    if (ch >= 0x20 && ch <= 0x3F) return CL_PARAM;
+    if (ch >= 0x40 && ch <= 0x7E) return CL_FINAL;
+    return CL_OTHER;
+}
+
+static void emit(KeyBatch* batch, i32 key) {
+    batch->keys[batch->count++] = key;
+}
+
+static void emit_plain(KeyBatch* batch, u8 ch) {
+    if (input.paste) {
+        emit(batch, ch);
+        return;
+    }
+    if (ch == '\n' || ch == '\r') emit(batch, KEY_ENTER);
+    else if (ch == 127 || ch == 8) emit(batch, KEY_BACK);
+    else emit(batch, ch);
+}
+
+static void dispatch(KeyBatch* batch) {
+    i32 key = KEY_OTHER;
+    for (u32 i = 0; i < sizeof(ESCAPE_KEYS) / sizeof(ESCAPE_KEYS[0]); ++i) {
+        if ((i32)std::strlen(ESCAPE_KEYS[i].seq) == input.seq_len &&
+            std::memcmp(ESCAPE_KEYS[i].seq, input.seq, input.seq_len) == 0) {
+            key = ESCAPE_KEYS[i].key;
+            break;
+        }
+    }
+
+    if (input.paste && key != KEY_PASTE_END) {
+        // pasted text that merely looks like a sequence stays text
+        emit(batch, 0x1B);
+        for (i32 i = 0; i < input.seq_len; ++i) emit(batch, (u8)input.seq[i]);
+        return;
+    }
+    if (key == KEY_PASTE_BEGIN) input.paste = true;
+    if (key == KEY_PASTE_END)   input.paste = false;
+    emit(batch, key);
+}
+
+// Decodes buffered bytes until they run out or the batch is full. A sequence cut off
+// at the end of the buffer stays in `state` and continues with the next read.
+static void decode(KeyBatch* batch) {
+    // ESC plus the longest sequence can add this many keys for one byte (paste fallback)
+    while (input.pos < input.len && batch->count <= KEY_BATCH_MAX - (ESCAPE_SEQ_MAX + 1)) {
+        u8 ch = input.buf[input.pos++];
+        const Transition& t = DECODE_TABLE[input.state][classify(ch)];
+        input.state = t.next;
+
+        switch (t.action) {
+        case ACT_EMIT:
+            emit_plain(batch, ch);
+            break;
+        case ACT_START:
+            input.seq_len = 0;
+            break;
+        case ACT_COLLECT:
+            // an overlong sequence is still consumed up to its final byte, it just matches nothing
+            if (input.seq_len < ESCAPE_SEQ_MAX - 1) input.seq[input.seq_len++] = (char)ch;
+            break;
+        case ACT_DISPATCH:
+            if (input.seq_len < ESCAPE_SEQ_MAX) input.seq[input.seq_len++] = (char)ch;
+            dispatch(batch);
+            break;
+        case ACT_ALT:
+            // ESC followed by a plain byte: the ESC was a key of its own
+            emit(batch, input.paste ? 0x1B : KEY_ESC);
+            input.pos--;
+            break;
+        case ACT_ABORT:
+            emit(batch, input.paste ? 0x1B : KEY_OTHER);
+            if (ch == 0x1B) input.pos--;
+            break;
+        }
+    }
+}
+
+// Waits up to timeout_ms (-1 = forever) and reads everything available in one call.
+static i32 fill_input(i32 timeout_ms) {
+    if (timeout_ms >= 0) {
+        struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+        if (poll(&pfd, 1, timeout_ms) <= 0) return 0;
+    }
+    ssize_t n;
+    do {
+        n = read(STDIN_FILENO, input.buf, sizeof(input.buf));
+    } while (n < 0 && errno == EINTR);
+    input.pos = 0;
+    input.len = n > 0 ? (i32)n : 0;
+    return n > 0 ? (i32)n : -1;
+}
+
+i32 get_keys(KeyBatch* batch) {
+    batch->count = 0;
+
+    // keys get_key() decoded but did not hand out yet come first
+    while (pending_pos < pending.count) batch->keys[batch->count++] = pending.keys[pending_pos++];
+    if (batch->count > 0) return batch->count;
+
+    while (batch->count == 0) {
+        if (input.pos == input.len) {
+            if (fill_input(-1) < 0) return 0;   // end of input
+        }
+        decode(batch);
+
+        // an unfinished sequence at the end of the read: give the rest ESC_TIMEOUT_MS to arrive
+        while (input.pos == input.len && input.state != ST_GROUND && batch->count < KEY_BATCH_MAX - ESCAPE_SEQ_MAX) {
+            if (fill_input(ESC_TIMEOUT_MS) > 0) {
+                decode(batch);
+                continue;
+            }
+            if (input.paste) {
+                emit(batch, 0x1B);
+                for (i32 i = 0; i < input.seq_len; ++i) emit(batch, (u8)input.seq[i]);
+            } else {
+                emit(batch, input.state == ST_ESC ? KEY_ESC : KEY_OTHER);
             }
+            input.state = ST_GROUND;
         }
-        return KEY_OTHER;
     }
+    return batch->count;
+}
 
-    if (ch == '\n' || ch == '\r') return KEY_ENTER;
-    if (ch == 127 || ch == 8)     return KEY_BACK;   // Backspace
+i32 get_key() {
+    if (pending_pos == pending.count) {
+        pending_pos = 0;
+        if (get_keys(&pending) == 0) return KEY_OTHER;
+    }
+    return pending.keys[pending_pos++];
+}
 
-    return ch;
+bool_t key_waiting() {
+    if (pending_pos < pending.count || input.pos < input.len) return 1;
+    struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+    return poll(&pfd, 1, 0) > 0;
+}
+
+static bool_t map_file(const char* path, const char** data, size_t* size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 0;
+    }
+    *size = (size_t)st.st_size;
+    *data = NULL;
+    if (*size > 0) {
+        void* mapped = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            return 0;
+        }
+        *data = (const char*)mapped;
+    }
+    close(fd);
+    return 1;
+}
+
+static void unmap_file(const char* data, size_t size) {
+    if (data) munmap((void*)data, size);
+}
+
+// background work: let the input thread have the CPU first (on Linux the nice value
+// is per thread, elsewhere it would apply to the whole process, so leave it)
+static void lower_thread_priority() {
+#if defined(__linux__)
+    setpriority(PRIO_PROCESS, 0, 19);
+#endif
 }
 
 #endif
@@ -113,62 +398,100 @@ void go_xy(i32 x, i32 y) {
 
 // ===================== UI Drawing =====================
 
-void draw_menu(const char* items[], i32 count, i32 sel) {
-    clear_screen();
+// Same as go_xy, but into a frame buffer instead of a flush per call
+static void append_xy(std::string& out, i32 x, i32 y) {
+    out += "\033[";
+    out += std::to_string(y);
+    out += ';';
+    out += std::to_string(x);
+    out += 'H';
+}
 
+static void menu_origin(i32 count, i32* start_x, i32* items_y) {
     // Simple fixed "virtual" terminal size
     const i32 term_cols = 80;
     const i32 term_rows = 25;
 
-    i32 start_x = (term_cols - MENU_WIDTH) / 2;
     i32 start_y = (term_rows - (count + 7)) / 2;
     if (start_y < 1) start_y = 1;
 
-    i32 y = start_y;
+    *start_x = (term_cols - MENU_WIDTH) / 2;
+    *items_y = start_y + 4;     // title (3 rows) and a blank row
+}
 
-    // Title
-    go_xy(start_x, y++);
-    std::cout << COLOR_TITLE_FG << "=======================================" << COLOR_RESET << "\n";
-    go_xy(start_x, y++);
-    std::cout << COLOR_TITLE_FG << "|          Simple Menu App            |" << COLOR_RESET << "\n";
-    go_xy(start_x, y++);
-    std::cout << COLOR_TITLE_FG << "=======================================" << COLOR_RESET << "\n\n";
+// pad: clear the rest of the menu width; a row switching selection only ever
+// replaces text on cells already blanked by the full paint, so it can skip this
+static void append_item(std::string& out, const char* item, bool_t selected, bool_t pad) {
+    if (selected) {
+        out += COLOR_HL_BG COLOR_HL_FG " -> ";
+        out += item;
+        out += " <- " COLOR_RESET;
+
+        i32 width = MENU_WIDTH - 7 - (i32)std::strlen(item);
+        if (pad && width > 0) out.append((size_t)width, ' ');
+    } else {
+        out += COLOR_NORMAL_FG "    ";
+        out += item;
+        out += "    " COLOR_RESET;
+    }
+}
 
-    y++;
+static void append_menu(std::string& out, const char* items[], i32 count, i32 sel) {
+    i32 start_x, y;
+    menu_origin(count, &start_x, &y);
+
+    out += "\033[2J\033[1;1H";
+
+    // Title
+    append_xy(out, start_x, y - 4);
+    out += COLOR_TITLE_FG "=======================================" COLOR_RESET;
+    append_xy(out, start_x, y - 3);
+    out += COLOR_TITLE_FG "|          Simple Menu App            |" COLOR_RESET;
+    append_xy(out, start_x, y - 2);
+    out += COLOR_TITLE_FG "=======================================" COLOR_RESET;
 
     // Menu items
     for (i32 i = 0; i < count; ++i) {
-        go_xy(start_x, y++);
-        if (i == sel) {
-            std::cout << COLOR_HL_BG << COLOR_HL_FG;
-            std::cout << " -> " << items[i] << " <- ";
-            std::cout << COLOR_RESET;
-
-            i32 pad = MENU_WIDTH - 7 - (i32)std::strlen(items[i]);
-            if (pad > 0) std::cout << std::string(pad, ' ');
-        } else {
-            std::cout << COLOR_NORMAL_FG;
-            std::cout << "    " << items[i] << "    ";
-            std::cout << COLOR_RESET;
-        }
-        std::cout << "\n";
+        append_xy(out, start_x, y++);
+        append_item(out, items[i], i == sel, true);
     }
+}
+
+void draw_menu(const char* items[], i32 count, i32 sel) {
+    std::string out;
+    append_menu(out, items, count, sel);
+    write_frame(out);
+}
 
-    // // Help text
-    // y++;
-    // go_xy(start_x, y++);
-    // std::cout << COLOR_TITLE_FG << "---------------------------------------" << COLOR_RESET << "\n";
-    // go_xy(start_x, y++);
-    // std::cout << "Use UP / DOWN to move, ENTER to select.\n";
-    // go_xy(start_x, y++);
-    // std::cout << "In content, press BACKSPACE or HOME to go back.\n";
-    // go_xy(start_x, y++);
-    // std::cout << "Select Exit to quit.\n";
-    // go_xy(start_x, y++);
-    // std::cout << COLOR_TITLE_FG << "---------------------------------------" << COLOR_RESET << "\n";
+void menu_init(MenuView* view, const char* items[], i32 count) {
+    view->items = items;
+    view->count = count;
+    view->drawn_sel = -1;
+}
 
-    // go_xy(1, term_rows);
-    // std::cout << std::flush;
+void menu_invalidate(MenuView* view) {
+    view->drawn_sel = -1;
+}
+
+i32 menu_render(MenuView* view, i32 sel) {
+    if (sel == view->drawn_sel) return 0;
+
+    std::string out;
+    if (view->drawn_sel < 0 || view->drawn_sel >= view->count) {
+        append_menu(out, view->items, view->count, sel);
+    } else {
+        i32 start_x, items_y;
+        menu_origin(view->count, &start_x, &items_y);
+
+        append_xy(out, start_x, items_y + view->drawn_sel);
+        append_item(out, view->items[view->drawn_sel], false, false);
+        append_xy(out, start_x, items_y + sel);
+        append_item(out, view->items[sel], true, false);
+    }
+
+    view->drawn_sel = sel;
+    write_frame(out);
+    return (i32)out.size();
 }
 
 void show_content(const char* word) {
@@ -214,6 +537,451 @@ void show_content(const char* word) {
     std::cout << std::flush;
 }
 
+// ===================== Filter menu =====================
+
+#define TRIGRAM_BITS    18
+#define TRIGRAM_BUCKETS (1u << TRIGRAM_BITS)
+#define FILTER_COLS     80
+#define FILTER_CLOCK_CHECKS 256     // item checks between looks at the clock
+#define FILTER_IDLE_US  500         // background search between looks for a key
+
+// How long one frame may search. Item checks cost anything from a mask test to a scan
+// of the raw text (before the index is ready), so the limit is time, not a count.
+typedef struct {
+    std::chrono::steady_clock::time_point deadline;
+    u32    checks_left;             // until the clock is read again
+    bool_t spent;
+} FilterBudget;
+
+static FilterBudget filter_budget(u32 micros) {
+    FilterBudget budget;
+    budget.deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(micros);
+    budget.checks_left = FILTER_CLOCK_CHECKS;
+    budget.spent = 0;
+    return budget;
+}
+
+// count one item check; every FILTER_CLOCK_CHECKS of them, see if the time is up
+static void budget_step(FilterBudget* budget) {
+    if (--budget->checks_left == 0) {
+        budget->checks_left = FILTER_CLOCK_CHECKS;
+        budget->spent = std::chrono::steady_clock::now() >= budget->deadline;
+    }
+}
+
+// Matches of one query prefix, filled in lazily. Candidates come from the previous
+// prefix's matches, or from a trigram posting list when that is the shorter list.
+typedef struct {
+    std::vector<u32> ids;       // matches so far, in file order
+    const u32* list;            // posting list source, NULL = previous level (or every item)
+    u32  list_len;
+    u32  cursor;                // next candidate in the source
+    bool_t done;
+} FilterLevel;
+
+struct FilterMenu {
+    const char* data;           // the mapped file
+    size_t size;
+    std::vector<u32> starts;    // item i is data[starts[i]] up to the newline
+
+    // built by the index thread, read only once `ready` is set
+    std::thread indexer;
+    std::atomic<bool> ready;
+    std::atomic<bool> cancel;
+    std::vector<u8>  folded;    // the file lowercased, same offsets as data
+    std::vector<u64> masks;     // per item, one bit per character class it contains
+    std::vector<u32> bucket_start;
+    std::vector<u32> postings;  // item ids per trigram hash bucket, ascending
+
+    char query[FILTER_QUERY_MAX];
+    i32  query_len;
+    std::vector<FilterLevel> levels;    // levels[k] matches query[0..k]
+
+    i32 sel;                    // rank in the current matches
+    i32 top;                    // rank shown in the first window row
+    std::vector<std::string> drawn;     // rows on screen, empty = repaint
+};
+
+static inline u8 fold(u8 ch) {
+    return (ch >= 'A' && ch <= 'Z') ? (u8)(ch + 32) : ch;
+}
+
+static inline u64 char_bit(u8 folded_ch) {
+    if (folded_ch >= 'a' && folded_ch <= 'z') return 1ull << (folded_ch - 'a');
+    if (folded_ch >= '0' && folded_ch <= '9') return 1ull << (26 + folded_ch - '0');
+    return 1ull << (36 + folded_ch % 28);
+}
+
+static inline u32 trigram_bucket(const u8* p) {
+    u32 t = ((u32)p[0] << 16) | ((u32)p[1] << 8) | p[2];
+    return (t * 2654435761u) >> (32 - TRIGRAM_BITS);
+}
+
+static u32 item_len(const FilterMenu* menu, u32 index) {
+    u32 begin = menu->starts[index];
+    u32 end = menu->starts[index + 1] - 1;      // minus the newline
+    if (end > begin && menu->data[end - 1] == '\r') end--;
+    return end - begin;
+}
+
+static u32 menu_items(const FilterMenu* menu) {
+    return (u32)menu->starts.size() - 1;
+}
+
+// Folded text, character masks and the trigram buckets (two passes: count, then fill;
+// `last` keeps an item from entering one bucket twice).
+static void build_index(FilterMenu* menu) {
+    lower_thread_priority();
+    try {
+        u32 count = menu_items(menu);
+        std::vector<u8> folded(menu->size);
+        std::vector<u64> masks(count);
+        std::vector<u32> bucket_start(TRIGRAM_BUCKETS + 1, 0);
+        std::vector<u32> last(TRIGRAM_BUCKETS, 0);
+
+        for (size_t i = 0; i < menu->size; ++i) folded[i] = fold((u8)menu->data[i]);
+
+        for (u32 item = 0; item < count && !menu->cancel.load(std::memory_order_relaxed); ++item) {
+            const u8* text = &folded[menu->starts[item]];
+            u32 len = item_len(menu, item);
+            u64 mask = 0;
+            for (u32 i = 0; i < len; ++i) mask |= char_bit(text[i]);
+            masks[item] = mask;
+            for (u32 i = 0; i + 3 <= len; ++i) {
+                u32 bucket = trigram_bucket(text + i);
+                if (last[bucket] == item + 1) continue;
+                last[bucket] = item + 1;
+                bucket_start[bucket + 1]++;
+            }
+        }
+        if (menu->cancel.load(std::memory_order_relaxed)) return;
+
+        for (u32 b = 0; b < TRIGRAM_BUCKETS; ++b) bucket_start[b + 1] += bucket_start[b];
+        std::vector<u32> postings(bucket_start[TRIGRAM_BUCKETS]);
+        std::vector<u32> fill(bucket_start.begin(), bucket_start.end() - 1);
+        std::fill(last.begin(), last.end(), 0);
+        for (u32 item = 0; item < count && !menu->cancel.load(std::memory_order_relaxed); ++item) {
+            const u8* text = &folded[menu->starts[item]];
+            u32 len = item_len(menu, item);
+            for (u32 i = 0; i + 3 <= len; ++i) {
+                u32 bucket = trigram_bucket(text + i);
+                if (last[bucket] == item + 1) continue;
+                last[bucket] = item + 1;
+                postings[fill[bucket]++] = item;
+            }
+        }
+        if (menu->cancel.load(std::memory_order_relaxed)) return;
+
+        menu->folded.swap(folded);
+        menu->masks.swap(masks);
+        menu->bucket_start.swap(bucket_start);
+        menu->postings.swap(postings);
+        menu->ready.store(true, std::memory_order_release);
+    } catch (const std::bad_alloc&) {
+        // no index: filtering still works, by scanning
+    }
+}
+
+FilterMenu* filter_open(const char* path) {
+    FilterMenu* menu = new FilterMenu;
+    if (!map_file(path, &menu->data, &menu->size) || menu->size >= 0xFFFFFFFFu) {
+        if (menu->data) unmap_file(menu->data, menu->size);
+        delete menu;
+        return NULL;
+    }
+
+    // item starts only; everything else is derived in the background
+    const char* p = menu->data;
+    const char* end = menu->data + menu->size;
+    while (p < end) {
+        menu->starts.push_back((u32)(p - menu->data));
+        const char* nl = (const char*)std::memchr(p, '\n', (size_t)(end - p));
+        p = nl ? nl + 1 : end;
+    }
+    // a sentinel one past the final newline, so item_len works for the last item too
+    u32 tail = (u32)menu->size;
+    if (menu->size > 0 && menu->data[menu->size - 1] != '\n') tail++;
+    menu->starts.push_back(tail);
+
+    menu->ready.store(false);
+    menu->cancel.store(false);
+    menu->query_len = 0;
+    menu->sel = 0;
+    menu->top = 0;
+    menu->indexer = std::thread(build_index, menu);
+    return menu;
+}
+
+void filter_close(FilterMenu* menu) {
+    if (!menu) return;
+    menu->cancel.store(true);
+    menu->indexer.join();
+    unmap_file(menu->data, menu->size);
+    delete menu;
+}
+
+i32 filter_item_count(const FilterMenu* menu) {
+    return (i32)menu_items(menu);
+}
+
+const char* filter_item(const FilterMenu* menu, i32 index, i32* len) {
+    *len = (i32)item_len(menu, (u32)index);
+    return menu->data + menu->starts[index];
+}
+
+// needle in already folded text: memchr to each candidate start, then compare
+static bool_t contains(const u8* text, u32 len, const u8* needle, u32 nlen) {
+    const u8* end = text + (len - nlen) + 1;
+    for (const u8* p = text; p < end; ++p) {
+        p = (const u8*)std::memchr(p, needle[0], (size_t)(end - p));
+        if (!p) return 0;
+        if (std::memcmp(p, needle, nlen) == 0) return 1;
+    }
+    return 0;
+}
+
+// case-insensitive substring test of the first `qlen` query characters
+static bool_t item_matches(const FilterMenu* menu, u32 item, i32 qlen, bool_t indexed) {
+    u32 len = item_len(menu, item);
+    if ((u32)qlen > len) return 0;
+
+    if (indexed) {
+        u64 need = 0;
+        for (i32 i = 0; i < qlen; ++i) need |= char_bit((u8)menu->query[i]);
+        if ((menu->masks[item] & need) != need) return 0;
+        return contains((const u8*)&menu->folded[menu->starts[item]], len, (const u8*)menu->query, (u32)qlen);
+    }
+
+    const u8* text = (const u8*)menu->data + menu->starts[item];
+    for (u32 at = 0; at + (u32)qlen <= len; ++at) {
+        i32 i = 0;
+        while (i < qlen && fold(text[at + i]) == (u8)menu->query[i]) ++i;
+        if (i == qlen) return 1;
+    }
+    return 0;
+}
+
+// Grows levels[k] until it holds `want` matches, runs out of candidates or the
+// budget (shared with the levels below) is spent.
+static void level_fill(FilterMenu* menu, i32 k, u32 want, FilterBudget* budget) {
+    FilterLevel& level = menu->levels[k];
+    bool_t indexed = menu->ready.load(std::memory_order_acquire);
+
+    while (level.ids.size() < want && !level.done && !budget->spent) {
+        u32 candidate;
+        if (level.list) {
+            if (level.cursor == level.list_len) {
+                level.done = 1;
+                break;
+            }
+            candidate = level.list[level.cursor++];
+        } else if (k == 0) {
+            if (level.cursor == menu_items(menu)) {
+                level.done = 1;
+                break;
+            }
+            candidate = level.cursor++;
+        } else {
+            FilterLevel& parent = menu->levels[k - 1];
+            if (level.cursor == parent.ids.size()) {
+                if (!parent.done) level_fill(menu, k - 1, (u32)parent.ids.size() + 256, budget);
+                if (level.cursor == parent.ids.size()) {
+                    if (parent.done) level.done = 1;
+                    break;
+                }
+            }
+            candidate = parent.ids[level.cursor++];
+        }
+
+        // the parent's fill may have spent the budget already, this check is still made
+        budget_step(budget);
+        if (item_matches(menu, candidate, k + 1, indexed)) level.ids.push_back(candidate);
+    }
+}
+
+// Typing a character adds a level. Its candidates are the previous matches, unless the
+// index has a trigram of the query whose bucket is smaller than those can be.
+static void filter_push(FilterMenu* menu, u8 ch) {
+    if (menu->query_len == FILTER_QUERY_MAX) return;
+    menu->query[menu->query_len++] = (char)fold(ch);
+
+    FilterLevel level;
+    level.list = NULL;
+    level.list_len = 0;
+    level.cursor = 0;
+    level.done = 0;
+
+    if (menu->query_len >= 3 && menu->ready.load(std::memory_order_acquire)) {
+        const FilterLevel* parent = &menu->levels.back();
+        u32 best = parent->done ? (u32)parent->ids.size() : menu_items(menu);
+        for (i32 i = 0; i + 3 <= menu->query_len; ++i) {
+            u32 bucket = trigram_bucket((const u8*)menu->query + i);
+            u32 size = menu->bucket_start[bucket + 1] - menu->bucket_start[bucket];
+            if (size < best) {
+                best = size;
+                level.list = &menu->postings[menu->bucket_start[bucket]];
+                level.list_len = size;
+            }
+        }
+    }
+
+    menu->levels.push_back(level);
+    menu->sel = 0;
+    menu->top = 0;
+}
+
+// backspace: the previous level still has its matches, nothing is recomputed
+static void filter_pop(FilterMenu* menu) {
+    if (menu->query_len == 0) return;
+    menu->query_len--;
+    menu->levels.pop_back();
+    menu->sel = 0;
+    menu->top = 0;
+}
+
+// matches known so far for the current query, and whether that is all of them
+static u32 filter_found(const FilterMenu* menu, bool_t* done) {
+    if (menu->levels.empty()) {
+        *done = 1;
+        return menu_items(menu);
+    }
+    *done = menu->levels.back().done;
+    return (u32)menu->levels.back().ids.size();
+}
+
+static void filter_work(FilterMenu* menu, u32 want, u32 micros) {
+    FilterBudget budget = filter_budget(micros);
+    if (!menu->levels.empty()) level_fill(menu, (i32)menu->levels.size() - 1, want, &budget);
+}
+
+static u32 filter_rank_item(const FilterMenu* menu, i32 rank) {
+    return menu->levels.empty() ? (u32)rank : menu->levels.back().ids[rank];
+}
+
+static void append_filter_row(std::string& out, const FilterMenu* menu, i32 rank, u32 found) {
+    std::string text;
+    if ((u32)rank < found) {
+        i32 len;
+        const char* item = filter_item(menu, (i32)filter_rank_item(menu, rank), &len);
+        if (len > FILTER_COLS - 4) {
+            len = FILTER_COLS - 4;
+            // do not cut a UTF-8 sequence in half
+            while (len > 0 && ((u8)item[len] & 0xC0) == 0x80) --len;
+        }
+        text.assign(rank == menu->sel ? " -> " : "    ");
+        for (i32 i = 0; i < len; ++i) text += (u8)item[i] < 0x20 ? '?' : item[i];
+    }
+    if (rank == menu->sel && (u32)rank < found) out += COLOR_HL_BG COLOR_HL_FG;
+    out += text;
+    out += COLOR_RESET "\033[K";
+}
+
+// Draws the query line, the status line and the visible window, writing only the rows
+// that differ from what is on screen, in one write.
+static void filter_render(FilterMenu* menu) {
+    bool_t done;
+    u32 found = filter_found(menu, &done);
+
+    std::vector<std::string> rows(FILTER_WINDOW_ROWS + 3);
+    rows[0] = COLOR_TITLE_FG "Filter: " COLOR_RESET;
+    rows[0].append(menu->query, (size_t)menu->query_len);
+    rows[0] += "_\033[K";
+
+    char status[96];
+    std::snprintf(status, sizeof(status), "%u%s of %d items%s", found, done ? "" : "+",
+                  filter_item_count(menu), done ? "" : "  (searching)");
+    rows[1] = COLOR_NORMAL_FG;
+    rows[1] += status;
+    rows[1] += COLOR_RESET "\033[K";
+    rows[2] = COLOR_TITLE_FG + std::string(FILTER_COLS, '-') + COLOR_RESET;
+
+    for (i32 r = 0; r < FILTER_WINDOW_ROWS; ++r) append_filter_row(rows[r + 3], menu, menu->top + r, found);
+
+    std::string out;
+    if (menu->drawn.size() != rows.size()) {
+        out += "\033[2J";
+        menu->drawn.assign(rows.size(), std::string());
+    }
+    for (size_t r = 0; r < rows.size(); ++r) {
+        if (rows[r] == menu->drawn[r]) continue;
+        append_xy(out, 1, (i32)r + 1);
+        out += rows[r];
+        menu->drawn[r].swap(rows[r]);
+    }
+    if (!out.empty()) write_frame(out);
+}
+
+static void filter_move(FilterMenu* menu, i32 delta) {
+    bool_t done;
+    i32 target = menu->sel + delta;
+    if (target < 0) target = 0;
+
+    // moving past the matches found so far looks for more first
+    u32 found = filter_found(menu, &done);
+    if ((u32)target >= found && !done) {
+        filter_work(menu, (u32)target + 1, FILTER_STEP_US);
+        found = filter_found(menu, &done);
+    }
+    if ((u32)target >= found) target = found > 0 ? (i32)found - 1 : 0;
+
+    menu->sel = target;
+    if (menu->sel < menu->top) menu->top = menu->sel;
+    if (menu->sel >= menu->top + FILTER_WINDOW_ROWS) menu->top = menu->sel - FILTER_WINDOW_ROWS + 1;
+}
+
+i32 filter_pick(FilterMenu* menu) {
+    menu->drawn.clear();
+
+    while (1) {
+        // the visible window first, within one frame's budget
+        filter_work(menu, (u32)(menu->top + FILTER_WINDOW_ROWS), FILTER_STEP_US);
+        filter_render(menu);
+
+        // then the rest of the matches in short slices, so a key that arrives meanwhile
+        // waits at most one slice
+        bool_t done;
+        filter_found(menu, &done);
+        while (!done && !key_waiting()) {
+            filter_work(menu, 0xFFFFFFFFu, FILTER_IDLE_US);
+            filter_found(menu, &done);
+            filter_render(menu);
+        }
+
+        KeyBatch batch;
+        if (get_keys(&batch) == 0) return -1;
+
+        for (i32 k = 0; k < batch.count; ++k) {
+            i32 key = batch.keys[k];
+            if (key == KEY_ENTER) {
+                // typed ahead of the search: finish looking for the selected match first
+                u32 found = filter_found(menu, &done);
+                while ((u32)menu->sel >= found && !done) {
+                    filter_work(menu, (u32)menu->sel + 1, FILTER_STEP_US);
+                    found = filter_found(menu, &done);
+                }
+                if ((u32)menu->sel < found) return (i32)filter_rank_item(menu, menu->sel);
+            } else if (key == KEY_ESC) {
+                if (menu->query_len == 0) return -1;
+                while (menu->query_len > 0) filter_pop(menu);
+            } else if (key == KEY_BACK) {
+                filter_pop(menu);
+            } else if (key == KEY_UP) {
+                filter_move(menu, -1);
+            } else if (key == KEY_DOWN) {
+                filter_move(menu, 1);
+            } else if (key == KEY_PGUP) {
+                filter_move(menu, -FILTER_WINDOW_ROWS);
+            } else if (key == KEY_PGDN) {
+                filter_move(menu, FILTER_WINDOW_ROWS);
+            } else if (key == KEY_HOME) {
+                filter_move(menu, -menu->sel);
+            } else if (key >= 0x20 && key < 0x7F) {
+                filter_push(menu, (u8)key);
+            }
+        }
+    }
+}
+
 // ===================== Main app loop =====================
 
 i32 run_app() {
@@ -226,42 +994,55 @@ i32 run_app() {
 
     std::string content_word = "New";  // word shown in content mode
 
+    MenuView menu;
+    menu_init(&menu, items, MENU_ITEM_COUNT);
+    i32 drawn_mode = -1;        // what the screen shows, content is only drawn on entry
+
     while (running) {
         if (mode == 0) {
-            // MENU MODE
-            draw_menu(items, MENU_ITEM_COUNT, sel);
-        } else {
+            // MENU MODE: only rows whose selection changed are rewritten
+            if (drawn_mode != 0) menu_invalidate(&menu);
+            menu_render(&menu, sel);
+        } else if (drawn_mode != 1) {
             // CONTENT MODE
             show_content(content_word.c_str());
         }
+        drawn_mode = mode;
 
-        i32 key = get_key();
+        // everything typed since the last redraw is applied before the next one,
+        // so a burst of queued DOWN presses costs a single draw_menu
+        KeyBatch batch;
+        if (get_keys(&batch) == 0) running = false;   // input closed
 
-        if (mode == 0) {
-            // ===== MENU MODE =====
-            if (key == KEY_UP) {
-                sel = (sel - 1 + MENU_ITEM_COUNT) % MENU_ITEM_COUNT;
-            } else if (key == KEY_DOWN) {
-                sel = (sel + 1) % MENU_ITEM_COUNT;
-            } else if (key == KEY_ENTER) {
-                if (sel == 0) {
-                    // New
-                    content_word = "New";
-                    mode = 1;
-                } else if (sel == 1) {
-                    // Display
-                    content_word = "Display";
-                    mode = 1;
-                } else if (sel == 2) {
-                    // Exit
-                    running = false;   // no break
+        for (i32 k = 0; k < batch.count && running; ++k) {
+            i32 key = batch.keys[k];
+
+            if (mode == 0) {
+                // ===== MENU MODE =====
+                if (key == KEY_UP) {
+                    sel = (sel - 1 + MENU_ITEM_COUNT) % MENU_ITEM_COUNT;
+                } else if (key == KEY_DOWN) {
+                    sel = (sel + 1) % MENU_ITEM_COUNT;
+                } else if (key == KEY_ENTER) {
+                    if (sel == 0) {
+                        // New
+                        content_word = "New";
+                        mode = 1;
+                    } else if (sel == 1) {
+                        // Display
+                        content_word = "Display";
+                        mode = 1;
+                    } else if (sel == 2) {
+                        // Exit
+                        running = false;   // no break
+                    }
+                }
+            } else {
+                // ===== CONTENT MODE =====
+                if (key == KEY_BACK || key == KEY_HOME) {
+                    // Back to menu
+                    mode = 0;
                 }
-            }
-        } else {
-            // ===== CONTENT MODE =====
-            if (key == KEY_BACK || key == KEY_HOME) {
-                // Back to menu
-                mode = 0;
             }
         }
     }
@@ -271,3 +1052,25 @@ i32 run_app() {
     std::cout << "Goodbye!\n";
     return 0;
 }
+
+i32 run_picker(const char* path) {
+    FilterMenu* menu = filter_open(path);
+    if (!menu) {
+        std::perror(path);
+        return 1;
+    }
+
+    start_console();
+    i32 chosen = filter_pick(menu);
+    stop_console();
+    clear_screen();
+
+    if (chosen >= 0) {
+        i32 len;
+        const char* item = filter_item(menu, chosen, &len);
+        std::cout.write(item, len);
+        std::cout << "\n";
+    }
+    filter_close(menu);
+    return chosen >= 0 ? 0 : 1;
+}
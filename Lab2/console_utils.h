@@ -16,8 +16,27 @@
 #define KEY_ENTER    1003
 #define KEY_BACK     1004
 #define KEY_HOME     1005
+#define KEY_END      1006
+#define KEY_PGUP     1007
+#define KEY_PGDN     1008
+#define KEY_LEFT     1009
+#define KEY_RIGHT    1010
+#define KEY_DELETE   1011
+#define KEY_ESC      1012   // a lone ESC, once ESC_TIMEOUT_MS passes with nothing after it
+#define KEY_PASTE_BEGIN 1013   // bracketed paste: the bytes in between arrive as plain characters,
+#define KEY_PASTE_END   1014   // '\n' and 127 included, never as KEY_ENTER / KEY_BACK
 #define KEY_OTHER    1999
 
+// Input batching
+#define KEY_BATCH_MAX   256     // keys handed back by one get_keys()
+#define INPUT_BUF_BYTES 4096    // bytes taken by one read()
+#define ESC_TIMEOUT_MS  50      // wait for the rest of an escape sequence
+
+typedef struct {
+    i32 keys[KEY_BATCH_MAX];
+    i32 count;
+} KeyBatch;
+
 #define MENU_ITEM_COUNT 3
 #define MENU_WIDTH      39
 
@@ -27,12 +46,42 @@ void stop_console();
 void clear_screen();
 void go_xy(i32 x, i32 y);
 i32  get_key();
+i32  get_keys(KeyBatch* batch);   // blocks for at least one key, returns batch->count (0 = input closed)
+bool_t key_waiting();             // a key is ready, get_keys() would not block
+
+// Retained-mode menu: remembers which selection is on screen, so a selection
+// change rewrites just the old and the new item row.
+typedef struct {
+    const char** items;
+    i32 count;
+    i32 drawn_sel;      // selection currently on screen, -1 = repaint everything
+} MenuView;
 
 // UI
 void draw_menu(const char* items[], i32 count, i32 sel);
+void menu_init(MenuView* view, const char* items[], i32 count);
+void menu_invalidate(MenuView* view);          // something else drew over the menu
+i32  menu_render(MenuView* view, i32 sel);     // one write, returns the bytes sent
 void show_content(const char* word);
 
+// Type-to-filter picker over a file with one item per line. The file is mapped, not
+// copied; a background thread builds a trigram index. Each typed character narrows
+// the previous result set, and a keystroke searches for at most FILTER_STEP_US before
+// its frame is drawn, the rest of the search runs while no key is waiting.
+#define FILTER_WINDOW_ROWS  20      // items visible at once
+#define FILTER_STEP_US      1500    // search time per frame
+#define FILTER_QUERY_MAX    64
+
+typedef struct FilterMenu FilterMenu;
+
+FilterMenu* filter_open(const char* path);      // NULL if the file cannot be read
+void        filter_close(FilterMenu* menu);
+i32         filter_item_count(const FilterMenu* menu);
+const char* filter_item(const FilterMenu* menu, i32 index, i32* len);   // not NUL-terminated
+i32         filter_pick(FilterMenu* menu);      // interactive, returns the chosen index or -1
+
 // Main loop
 i32  run_app();
+i32  run_picker(const char* path);   // prints the chosen line, returns 1 if nothing was chosen
 
 #endif
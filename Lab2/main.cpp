@@ -1,4 +1,8 @@
 #include "console_utils.h"
-int main() {
+
+// usage: app            the fixed menu
+//        app ITEMS_FILE pick one line of ITEMS_FILE by typing to filter, print it
+int main(int argc, char** argv) {
+    if (argc > 1) return run_picker(argv[1]);
     return run_app();
-}
\ No newline at end of file
+}
@@ -3,6 +3,7 @@
 
 #include "custom_types.h"
 #include <stdio.h>
+#include <memory>
 
 #define DELAY_MS 150
 #define MAX_N    19
@@ -11,4 +12,219 @@ void delay_ms(u32 ms);
 void print_square(i32 n, u32 square[MAX_N][MAX_N]);
 void generate_magic(i32 n);
 
+// --- incremental rendering ---
+// Remembers what is on screen and redraws only the cells that changed since the last
+// frame, each frame going out in a single buffered write. The first frame is a full
+// print_square layout; after that the cursor stays below the grid and every changed
+// cell costs one short cursor-move-and-write sequence, so a frame's cost depends on
+// how many cells changed, not on N.
+
+#define RENDER_BUF_BYTES 4096       // initial frame buffer, grown for bigger full frames
+
+typedef struct {
+    u32    n;
+    i32    width;                   // characters per cell
+    u32*   shown;                   // the n * n values currently on screen, row-major
+    bool_t drawn;                   // first frame done
+    char*  buf;                     // the frame being built
+    u32    cap;
+    u32    len;
+    u32    frames;
+    u64    bytes_written;
+} SquareRenderer;
+
+// --- any-order construction ---
+// Every cell comes from a closed form in (row, col), so squares of any size can be
+// built straight into one flat buffer with no stepping and no MAX_N limit:
+//   odd N       the Siamese square (the same one generate_magic animates)
+//   N % 4 == 0  1..N*N in order, complemented on the diagonals of each 4x4 block
+//   N % 4 == 2  Conway's LUX method over the odd square of order N/2
+// There is no magic square of order 2.
+
+#define MAGIC_MAX_ORDER 65535       // N*N must fit in a u32
+
+// row-major N x N square on the heap: cell (row, col) is cells[(u64)row * n + col]
+typedef struct {
+    u32  n;
+    u32* cells;
+} MagicSquare;
+
+bool_t magic_order_supported(u32 n);
+u64    magic_sum(u32 n);
+
+// value of one cell of the order-n square
+u32    magic_cell(u32 n, u32 row, u32 col);
+
+// write one row of the order-n square into out[0..n)
+void   magic_fill_row(u32 n, u32 row, u32 out[]);
+
+// write rows [row_begin, row_end) of the order-n square into cells (the whole square's buffer)
+void   magic_fill_rows(u32 n, u32 cells[], u32 row_begin, u32 row_end);
+
+// allocate an unfilled square / allocate and fill one, 0 if n is unsupported or out of memory
+bool_t magic_alloc(MagicSquare* square, u32 n);
+bool_t magic_build(MagicSquare* square, u32 n);
+void   magic_free(MagicSquare* square);
+
+void   print_magic(const MagicSquare* square);
+
+// 0 if out of memory; a cell holding 0 is drawn blank
+bool_t renderer_init(SquareRenderer* r, u32 n);
+void   renderer_present(SquareRenderer* r, const MagicSquare* square);
+void   renderer_free(SquareRenderer* r);
+
+// --- parallel construction ---
+// The buffer is cut into tiles of whole rows (about tile_bytes each) that a pool of
+// threads takes one at a time, so a huge square is limited by memory bandwidth.
+
+typedef struct {
+    u32    threads;                 // 0 = one per hardware thread
+    u32    tile_bytes;              // 0 = 256 KB
+    bool_t pin;                     // pin worker i to CPU i (Linux only)
+} MagicBuildOptions;
+
+typedef struct {
+    double seconds;                 // allocation and fill
+    double cells_per_sec;
+    u32    threads;
+    u32    tiles;
+} MagicBuildStats;
+
+// fill an n * n buffer (heap, mmap'd file, ...) on several threads; options and stats may be NULL
+void   magic_fill_parallel(u32 n, u32 cells[], const MagicBuildOptions* options, MagicBuildStats* stats);
+
+// magic_build on several threads
+bool_t magic_build_parallel(MagicSquare* square, u32 n, const MagicBuildOptions* options, MagicBuildStats* stats);
+void   print_build_stats(u32 n, const MagicBuildStats* stats);
+
+// --- verification ---
+// One pass over the flat buffer checks every row, column and both diagonals against
+// n * (n*n + 1) / 2 and that the values are a permutation of 1..n*n.
+// Rows are split into bands across threads; each band keeps its own column sums as
+// n accumulator lanes, added one whole row at a time, so columns are never read
+// with a stride, and marks its values in its own bitset with plain stores. The bands'
+// lanes are merged at the end and their bitsets ORed together: n*n distinct values
+// means a permutation. Only a square that fails that is scanned again to find the cell.
+
+typedef enum {
+    MAGIC_OK,
+    MAGIC_OUT_OF_RANGE,             // a value outside 1..n*n
+    MAGIC_DUPLICATE,                // a value seen before
+    MAGIC_BAD_ROW,
+    MAGIC_BAD_COLUMN,
+    MAGIC_BAD_DIAGONAL,             // (0, 0) .. (n-1, n-1)
+    MAGIC_BAD_ANTI_DIAGONAL         // (0, n-1) .. (n-1, 0)
+} MagicViolation;
+
+// the first problem found: bad values first, then rows, columns, diagonals,
+// each in reading order (for a duplicate, the later copy)
+typedef struct {
+    MagicViolation kind;
+    u32 row;
+    u32 col;
+    u64 expected;                   // the magic sum, or n*n for MAGIC_OUT_OF_RANGE
+    u64 actual;                     // the sum, or the offending value
+} MagicCheck;
+
+// threads = 0: one per hardware thread (small squares use fewer)
+MagicCheck magic_verify(u32 n, const u32 cells[], u32 threads);
+void       print_check(const MagicCheck* check);
+
+// --- enumeration ---
+// Counts (and optionally lists) every magic square of a small order by backtracking.
+// Cells are filled in L shapes: for i = 0, 1, ... row i from the diagonal to the right
+// edge, then column i below the diagonal, so each row and column is completed as early
+// as possible. Each cell's candidates are a bitmask of the free values that keep
+// its row, column and diagonals able to reach the magic sum; the last cell of a line
+// is forced. Corner ordering keeps one square of each class of 8 rotations and
+// reflections. The tree is cut into subtrees a few cells deep that worker threads
+// pop from their own deque and steal from each other's; a worker holding a task
+// while others sit idle splits it one level further so there is something to steal.
+// Workers with nothing to steal sleep on a condition variable until tasks are pushed
+// or the last one is done.
+// Order 4 is exhaustive in well under a second; order 5 (about 2.75e8 classes) is
+// meant for max_nodes or sample runs.
+
+#define ENUM_MAX_ORDER 6            // values up to 36 fit the u64 candidate masks
+
+typedef struct {
+    u32    n;
+    u32    threads;                 // 0 = one per hardware thread
+    u32    split_depth;             // cells fixed in the initial subtrees, 0 = n + 1
+    u64    max_nodes;               // stop after about this many nodes, 0 = no limit
+    u32    sample;                  // search only this many random subtrees, 0 = all
+    u32    seed;                    // for sample
+    bool_t progress;                // counters on stderr once a second
+    void (*on_square)(u32 n, const u8 cells[], void* user);     // one per class, may be NULL
+    void*  user;
+} EnumOptions;
+
+typedef struct {
+    u64    canonical;               // squares found, one per symmetry class
+    u64    total;                   // canonical * 8
+    u64    nodes;                   // values tried
+    u64    steals;
+    u64    subtrees;                // in the initial split
+    u64    subtrees_searched;
+    bool_t complete;                // every subtree, no node limit hit
+    bool_t stopped;                 // the node limit was hit
+    double estimate;                // canonical scaled up to all subtrees (sample runs)
+    double seconds;
+} EnumStats;
+
+// 0 if n is out of range
+bool_t magic_enumerate(const EnumOptions* options, EnumStats* stats);
+void   print_enum_stats(u32 n, const EnumStats* stats);
+
+// --- shared squares ---
+// get_magic() hands out finished squares from a process-wide LRU cache bounded by a
+// byte budget. Concurrent calls for the same order share a single build (the others
+// wait for it), and a square stays valid for as long as a caller holds its reference,
+// even after the cache has evicted it.
+
+// A cached square as callers see it. Every caller shares the same cells, so they are
+// const here: writing through a MagicRef does not compile.
+typedef struct {
+    u32        n;
+    const u32* cells;               // row-major: cell (row, col) is cells[(u64)row * n + col]
+} MagicView;
+
+typedef std::shared_ptr<const MagicView> MagicRef;
+
+typedef struct {
+    u64 hits;                       // served from the cache (waits included)
+    u64 misses;                     // builds started
+    u64 waits;                      // hits that waited for a build in progress
+    u64 evictions;
+    u32 entries;
+    u64 bytes;                      // held by finished entries
+    u64 budget;
+} MagicCacheStats;
+
+// the order-n square, an empty reference if n is unsupported or out of memory
+MagicRef        get_magic(u32 n);
+
+// default 256 MB; lowering it evicts right away. A square bigger than the whole
+// budget is still returned, just not kept.
+void            magic_cache_set_budget(u64 bytes);
+void            magic_cache_clear();
+MagicCacheStats magic_cache_stats();
+
+// --- batch mode ---
+// Non-interactive generation driven by the command line: no delay, no animation.
+// Squares are written back to back in the chosen format; raw output to a regular
+// file is mmap'd and filled in place by the parallel builder, everything else is
+// streamed row by row through a large aligned buffer.
+
+typedef enum {
+    FORMAT_RAW,                     // row-major little-endian u32, no header
+    FORMAT_CSV,                     // one row per line, squares separated by an empty line
+    FORMAT_TEXT                     // aligned columns, squares separated by an empty line
+} OutputFormat;
+
+// main() for "magic [-f raw|csv|text] [-o file] [-j threads] [-p] N [N ...]"
+//        and "magic [-j threads] -c square.bin" (verify a raw square)
+//        and "magic [-j threads] [-s subtrees] [-m nodes] [-l] -e N" (enumerate order N)
+i32 run_batch(i32 argc, char* argv[]);
+
 #endif
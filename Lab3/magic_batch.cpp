@@ -0,0 +1,377 @@
+#include "magic.h"
+#include "custom_types.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define OUT_BUFFER_BYTES (4 * 1024 * 1024)
+#define OUT_BUFFER_ALIGN 4096
+
+// --- buffered output ---
+// One big page-aligned buffer, handed to write() only when full.
+
+typedef struct {
+    i32    fd;
+    u8*    data;
+    u32    len;
+    u64    total;
+    bool_t failed;
+} OutBuffer;
+
+static bool_t write_all(i32 fd, const u8* data, u64 len) {
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        data += written;
+        len -= (u64)written;
+    }
+    return 1;
+}
+
+static void out_flush(OutBuffer* out) {
+    if (out->len == 0) return;
+    if (!out->failed && !write_all(out->fd, out->data, out->len)) out->failed = 1;
+    out->total += out->len;
+    out->len = 0;
+}
+
+// room for at least bytes more
+static inline u8* out_reserve(OutBuffer* out, u32 bytes) {
+    if (OUT_BUFFER_BYTES - out->len < bytes) out_flush(out);
+    return out->data + out->len;
+}
+
+static inline void out_byte(OutBuffer* out, u8 c) {
+    *out_reserve(out, 1) = c;
+    out->len++;
+}
+
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static inline u32 count_digits(u32 value) {
+    u32 digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+// decimal value right-aligned in width characters (space padded), returns the length
+static inline u32 format_cell(u32 value, u32 width, u8* out) {
+    u32 digits = count_digits(value);
+    u32 pad = width > digits ? width - digits : 0;
+    for (u32 k = 0; k < pad; k++) out[k] = ' ';
+
+    u8* p = out + pad + digits;
+    while (value >= 100) {
+        u32 pair = (value % 100) * 2;
+        value /= 100;
+        p -= 2;
+        p[0] = (u8)digit_pairs[pair];
+        p[1] = (u8)digit_pairs[pair + 1];
+    }
+    if (value >= 10) {
+        p -= 2;
+        p[0] = (u8)digit_pairs[value * 2];
+        p[1] = (u8)digit_pairs[value * 2 + 1];
+    } else {
+        *--p = (u8)('0' + value);
+    }
+    return pad + digits;
+}
+
+static inline u32 to_le32(u32 v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap32(v);
+#else
+    return v;
+#endif
+}
+
+// rows are generated one at a time, so memory use does not grow with n
+static void stream_square(OutBuffer* out, u32 n, OutputFormat format, u32 row_buf[]) {
+    u32 width = count_digits(n * n) + 1;
+    for (u32 row = 0; row < n; row++) {
+        if (format == FORMAT_RAW) {
+            u32* cells = (u32*)out_reserve(out, n * sizeof(u32));
+            magic_fill_row(n, row, cells);
+            for (u32 col = 0; col < n; col++) cells[col] = to_le32(cells[col]);
+            out->len += n * sizeof(u32);
+            continue;
+        }
+
+        magic_fill_row(n, row, row_buf);
+        for (u32 col = 0; col < n; col++) {
+            u8* p = out_reserve(out, 16);
+            if (format == FORMAT_CSV) {
+                u32 len = format_cell(row_buf[col], 0, p);
+                p[len] = col + 1 < n ? ',' : '\n';
+                out->len += len + 1;
+            } else {
+                out->len += format_cell(row_buf[col], width, p);
+            }
+        }
+        if (format == FORMAT_TEXT) out_byte(out, '\n');
+    }
+}
+
+// raw output to a regular file: size the file, map it and let the fill threads
+// write the cells straight into the page cache
+static bool_t write_raw_mapped(i32 fd, const u32 orders[], u32 count, const MagicBuildOptions* options) {
+    u64 total = 0;
+    for (u32 i = 0; i < count; i++) total += (u64)orders[i] * orders[i] * sizeof(u32);
+
+    // reserve the blocks up front so a full disk fails here and not as SIGBUS later
+    i32 err = posix_fallocate(fd, 0, (off_t)total);
+    if (err == EINVAL || err == EOPNOTSUPP) err = ftruncate(fd, (off_t)total) == 0 ? 0 : errno;
+    if (err != 0) return 0;
+
+    u8* map = (u8*)mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) return 0;
+
+    u64 offset = 0;
+    for (u32 i = 0; i < count; i++) {
+        u32 n = orders[i];
+        u32* cells = (u32*)(map + offset);
+        magic_fill_parallel(n, cells, options, NULL);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        for (u64 k = 0; k < (u64)n * n; k++) cells[k] = to_le32(cells[k]);
+#endif
+        offset += (u64)n * n * sizeof(u32);
+    }
+    return munmap(map, total) == 0;
+}
+
+// check a raw square from a file, its order comes from the file size
+static i32 verify_file(const char* path, u32 threads) {
+    i32 fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not open file for reading: %s\n", path);
+        return 1;
+    }
+    struct stat st;
+    u64 size = fstat(fd, &st) == 0 ? (u64)st.st_size : 0;
+    u32 n = 1;
+    while ((u64)(n + 1) * (n + 1) * sizeof(u32) <= size) n++;
+    if (size == 0 || (u64)n * n * sizeof(u32) != size) {
+        fprintf(stderr, "Error: %s is not a raw square (size %llu is not 4 * N * N).\n", path, size);
+        close(fd);
+        return 1;
+    }
+
+    u32* cells = (u32*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (cells == MAP_FAILED) {
+        fprintf(stderr, "Error: Could not map %s.\n", path);
+        return 1;
+    }
+    madvise(cells, size, MADV_SEQUENTIAL);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (u64 k = 0; k < (u64)n * n; k++) cells[k] = to_le32(cells[k]);     // private copy
+#endif
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    MagicCheck check = magic_verify(n, cells, threads);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    munmap(cells, size);
+
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("N=%u: ", n);
+    print_check(&check);
+    fprintf(stderr, "Checked %llu bytes in %.3f s (%.1f MB/s)\n",
+            size, seconds, seconds > 0 ? (double)size / seconds / 1e6 : 0.0);
+    return check.kind == MAGIC_OK ? 0 : 2;
+}
+
+static void print_found_square(u32 n, const u8 cells[], void* user) {
+    u64* count = (u64*)user;
+    printf("#%llu\n", ++*count);
+    for (u32 r = 0; r < n; r++) {
+        for (u32 c = 0; c < n; c++) printf("%3u", cells[r * n + c]);
+        printf("\n");
+    }
+}
+
+static i32 enumerate(u32 n, const EnumOptions* base, bool_t list) {
+    EnumOptions options = *base;
+    u64 listed = 0;
+    options.n = n;
+    options.progress = 1;
+    if (list) {
+        options.on_square = print_found_square;
+        options.user = &listed;
+    }
+
+    EnumStats stats;
+    if (!magic_enumerate(&options, &stats)) {
+        fprintf(stderr, "Error: enumeration supports orders 1..%d.\n", ENUM_MAX_ORDER);
+        return 1;
+    }
+    print_enum_stats(n, &stats);
+    return 0;
+}
+
+static void batch_usage() {
+    printf("usage: magic [-f raw|csv|text] [-o file] [-j threads] [-p] N [N ...]\n");
+    printf("       magic [-j threads] -c square.bin\n");
+    printf("       magic [-j threads] [-s subtrees] [-m nodes] [-l] -e N\n");
+    printf("  -f  output format: raw little-endian u32 (default), csv or text\n");
+    printf("  -o  output file (default: stdout)\n");
+    printf("  -j  threads for raw output to a file or for checking (default: all)\n");
+    printf("  -p  pin those threads to CPUs\n");
+    printf("  -c  verify a raw square instead of generating\n");
+    printf("  -e  count every magic square of order N (up to %d) instead of generating\n", ENUM_MAX_ORDER);
+    printf("  -s  search only this many random subtrees and estimate the total\n");
+    printf("  -m  stop after about this many search nodes\n");
+    printf("  -l  list the squares found, one per symmetry class\n");
+}
+
+i32 run_batch(i32 argc, char* argv[]) {
+    OutputFormat format = FORMAT_RAW;
+    const char* path = NULL;
+    const char* check_path = NULL;
+    u32 enum_order = 0;
+    bool_t list = 0;
+    EnumOptions enum_options = {};
+    MagicBuildOptions options = { 0, 0, 0 };
+
+    i32 arg = 1;
+    while (arg < argc && argv[arg][0] == '-') {
+        if (strcmp(argv[arg], "-p") == 0 || strcmp(argv[arg], "-l") == 0) {
+            if (argv[arg][1] == 'p') options.pin = 1;
+            else list = 1;
+            arg++;
+            continue;
+        }
+        if (arg + 1 >= argc) {
+            batch_usage();
+            return 1;
+        }
+        const char* value = argv[arg + 1];
+        if (strcmp(argv[arg], "-f") == 0 && strcmp(value, "raw") == 0) {
+            format = FORMAT_RAW;
+        } else if (strcmp(argv[arg], "-f") == 0 && strcmp(value, "csv") == 0) {
+            format = FORMAT_CSV;
+        } else if (strcmp(argv[arg], "-f") == 0 && strcmp(value, "text") == 0) {
+            format = FORMAT_TEXT;
+        } else if (strcmp(argv[arg], "-o") == 0) {
+            path = strcmp(value, "-") == 0 ? NULL : value;
+        } else if (strcmp(argv[arg], "-c") == 0) {
+            check_path = value;
+        } else if (strcmp(argv[arg], "-e") == 0 && atoi(value) > 0) {
+            enum_order = (u32)atoi(value);
+        } else if (strcmp(argv[arg], "-s") == 0 && atoi(value) > 0) {
+            enum_options.sample = (u32)atoi(value);
+            enum_options.seed = (u32)time(NULL);
+        } else if (strcmp(argv[arg], "-m") == 0 && atoll(value) > 0) {
+            enum_options.max_nodes = (u64)atoll(value);
+        } else if (strcmp(argv[arg], "-j") == 0 && atoi(value) > 0) {
+            options.threads = (u32)atoi(value);
+        } else {
+            batch_usage();
+            return 1;
+        }
+        arg += 2;
+    }
+    if (check_path != NULL && enum_order == 0 && arg == argc) {
+        return verify_file(check_path, options.threads);
+    }
+    if (enum_order != 0 && check_path == NULL && arg == argc) {
+        enum_options.threads = options.threads;
+        return enumerate(enum_order, &enum_options, list);
+    }
+    if (arg >= argc || check_path != NULL || enum_order != 0) {
+        batch_usage();
+        return 1;
+    }
+
+    u32 count = (u32)(argc - arg);
+    u32* orders = (u32*)malloc(count * sizeof(u32));
+    u32 max_order = 0;
+    for (u32 i = 0; i < count; i++) {
+        i32 n = atoi(argv[arg + i]);
+        if (n <= 0 || !magic_order_supported((u32)n)) {
+            fprintf(stderr, "Error: N must be 1 or 3..%d, got %s.\n", MAGIC_MAX_ORDER, argv[arg + i]);
+            free(orders);
+            return 1;
+        }
+        orders[i] = (u32)n;
+        if (orders[i] > max_order) max_order = orders[i];
+    }
+
+    i32 fd = STDOUT_FILENO;
+    if (path != NULL) {
+        fd = open(path, (format == FORMAT_RAW ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            fprintf(stderr, "Error: Could not open file for writing: %s\n", path);
+            free(orders);
+            return 1;
+        }
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    bool_t ok = 1;
+    u64 total = 0;
+    struct stat st;
+    if (format == FORMAT_RAW && path != NULL && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        ok = write_raw_mapped(fd, orders, count, &options);
+        for (u32 i = 0; i < count; i++) total += (u64)orders[i] * orders[i] * sizeof(u32);
+    } else {
+        OutBuffer out;
+        out.fd = fd;
+        out.data = (u8*)aligned_alloc(OUT_BUFFER_ALIGN, OUT_BUFFER_BYTES);
+        out.len = 0;
+        out.total = 0;
+        out.failed = 0;
+        u32* row_buf = (u32*)malloc((u64)max_order * sizeof(u32));
+        if (out.data == NULL || row_buf == NULL) {
+            ok = 0;
+        } else {
+            for (u32 i = 0; i < count && !out.failed; i++) {
+                if (i > 0 && format != FORMAT_RAW) out_byte(&out, '\n');
+                stream_square(&out, orders[i], format, row_buf);
+            }
+            out_flush(&out);
+            ok = !out.failed;
+        }
+        total = out.total;
+        free(row_buf);
+        free(out.data);
+    }
+
+    if (path != NULL && close(fd) != 0) ok = 0;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(orders);
+
+    if (!ok) {
+        fprintf(stderr, "Error: writing the output failed.\n");
+        return 1;
+    }
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    fprintf(stderr, "Wrote %llu bytes in %.3f s (%.1f MB/s)\n",
+            total, seconds, seconds > 0 ? (double)total / seconds / 1e6 : 0.0);
+    return 0;
+}
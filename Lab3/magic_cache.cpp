@@ -0,0 +1,144 @@
+#include "magic.h"
+#include "custom_types.h"
+#include <stdlib.h>
+#include <future>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#define DEFAULT_CACHE_BUDGET (256ull * 1024 * 1024)
+
+typedef struct {
+    u32 n;
+    u64 bytes;                      // 0 while the square is still being built
+    std::shared_future<MagicRef> square;
+} CacheEntry;
+
+// most recently used at the front; the map points into the list
+typedef struct {
+    std::mutex mutex;
+    std::list<CacheEntry> lru;
+    std::unordered_map<u32, std::list<CacheEntry>::iterator> by_order;
+    u64 budget = DEFAULT_CACHE_BUDGET;
+    u64 bytes = 0;
+    u64 hits = 0;
+    u64 misses = 0;
+    u64 waits = 0;
+    u64 evictions = 0;
+} MagicCache;
+
+static MagicCache& cache() {
+    static MagicCache instance;
+    return instance;
+}
+
+// drop least recently used finished squares until the budget holds; squares still
+// being built are skipped, callers already holding an evicted square keep it alive
+static void evict_to_budget(MagicCache& c) {
+    auto it = c.lru.end();
+    while (c.bytes > c.budget && it != c.lru.begin()) {
+        --it;
+        if (it->bytes == 0) continue;
+        c.bytes -= it->bytes;
+        c.evictions++;
+        c.by_order.erase(it->n);
+        it = c.lru.erase(it);
+    }
+}
+
+// the square and the read-only view handed out, freed together with the last reference
+typedef struct {
+    MagicSquare square;
+    MagicView   view;
+} SharedSquare;
+
+static MagicRef build_shared(u32 n) {
+    std::shared_ptr<SharedSquare> shared(new SharedSquare, [](SharedSquare* s) {
+        magic_free(&s->square);
+        delete s;
+    });
+    if (!magic_build_parallel(&shared->square, n, NULL, NULL)) return MagicRef();
+    shared->view.n = shared->square.n;
+    shared->view.cells = shared->square.cells;
+    return MagicRef(shared, &shared->view);
+}
+
+MagicRef get_magic(u32 n) {
+    if (!magic_order_supported(n)) return MagicRef();
+    MagicCache& c = cache();
+
+    std::unique_lock<std::mutex> lock(c.mutex);
+    auto found = c.by_order.find(n);
+    if (found != c.by_order.end()) {
+        c.lru.splice(c.lru.begin(), c.lru, found->second);
+        c.hits++;
+        if (found->second->bytes == 0) c.waits++;
+        std::shared_future<MagicRef> square = found->second->square;
+        lock.unlock();
+        return square.get();
+    }
+
+    // single flight: publish the pending entry first, so callers asking for the same
+    // order meanwhile wait on this build instead of starting their own
+    c.misses++;
+    std::promise<MagicRef> promise;
+    CacheEntry entry;
+    entry.n = n;
+    entry.bytes = 0;
+    entry.square = promise.get_future().share();
+    c.lru.push_front(entry);
+    c.by_order[n] = c.lru.begin();
+    lock.unlock();
+
+    MagicRef square = build_shared(n);
+    promise.set_value(square);
+
+    lock.lock();
+    found = c.by_order.find(n);
+    if (found != c.by_order.end()) {
+        if (square) {
+            found->second->bytes = (u64)n * n * sizeof(u32);
+            c.bytes += found->second->bytes;
+            evict_to_budget(c);
+        } else {
+            c.lru.erase(found->second);         // out of memory: let the next call retry
+            c.by_order.erase(found);
+        }
+    }
+    return square;
+}
+
+void magic_cache_set_budget(u64 bytes) {
+    MagicCache& c = cache();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    c.budget = bytes;
+    evict_to_budget(c);
+}
+
+void magic_cache_clear() {
+    MagicCache& c = cache();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    for (auto it = c.lru.begin(); it != c.lru.end();) {
+        if (it->bytes == 0) {
+            ++it;
+            continue;
+        }
+        c.bytes -= it->bytes;
+        c.by_order.erase(it->n);
+        it = c.lru.erase(it);
+    }
+}
+
+MagicCacheStats magic_cache_stats() {
+    MagicCache& c = cache();
+    std::lock_guard<std::mutex> lock(c.mutex);
+    MagicCacheStats stats;
+    stats.hits = c.hits;
+    stats.misses = c.misses;
+    stats.waits = c.waits;
+    stats.evictions = c.evictions;
+    stats.entries = (u32)c.lru.size();
+    stats.bytes = c.bytes;
+    stats.budget = c.budget;
+    return stats;
+}
@@ -0,0 +1,438 @@
+#include "magic.h"
+#include "custom_types.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define ENUM_MAX_SPLIT     12       // idle workers make busy ones split down to here
+#define ENUM_NODE_BATCH    4096     // nodes counted locally before touching the shared total
+
+#define ENUM_MAX_CELLS (ENUM_MAX_ORDER * ENUM_MAX_ORDER)
+#define NOT_ON_LINE    0xFF
+
+// a partial square: the first depth cells of the fill order are placed
+typedef struct {
+    u8  cells[ENUM_MAX_CELLS];      // row-major, 0 = empty
+    u32 row_sum[ENUM_MAX_ORDER];
+    u32 col_sum[ENUM_MAX_ORDER];
+    u32 diagonal;
+    u32 anti_diagonal;
+    u64 used;                       // bit v set once value v is placed
+    u32 depth;
+} EnumTask;
+
+// a worker's own tasks: it pushes and pops at the back, thieves take from the front
+typedef struct {
+    std::mutex mutex;
+    std::deque<EnumTask> tasks;
+} TaskDeque;
+
+typedef struct {
+    const EnumOptions* options;
+    u32 n;
+    u32 sum;
+    u64 all_values;                 // bits 1..n*n
+
+    // fill order: row i from the diagonal right, then column i below the diagonal, so
+    // every row and column is finished (its last cell forced) as early as possible
+    u8  order[ENUM_MAX_CELLS];      // cell index filled at each depth
+    u8  rest_row[ENUM_MAX_CELLS];   // cells of the same row filled after this depth
+    u8  rest_col[ENUM_MAX_CELLS];
+    u8  rest_diagonal[ENUM_MAX_CELLS];      // NOT_ON_LINE off the diagonal
+    u8  rest_anti_diagonal[ENUM_MAX_CELLS];
+
+    std::vector<TaskDeque*> deques;
+    std::atomic<u64> pending;       // tasks queued or running
+    std::atomic<u64> queued;        // tasks sitting in a deque
+    std::atomic<u32> idle;          // workers waiting for work
+    std::mutex idle_mutex;          // idle workers sleep on work_ready
+    std::condition_variable work_ready;     // tasks were pushed, or pending reached 0
+    std::atomic<bool_t> stop;       // node limit reached
+
+    std::atomic<u64> nodes;
+    std::atomic<u64> found;
+    std::atomic<u64> steals;
+    std::atomic<u64> tasks_done;
+    std::mutex output;
+} EnumShared;
+
+typedef struct {
+    EnumShared* shared;
+    u32 id;
+    u64 nodes;                      // not yet added to shared->nodes
+    u64 found;
+} EnumWorker;
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// sums of the k smallest / k largest values still free
+static inline u32 smallest_sum(u64 free_values, u32 k) {
+    u32 total = 0;
+    for (; k > 0 && free_values != 0; k--) {
+        total += (u32)__builtin_ctzll(free_values);
+        free_values &= free_values - 1;
+    }
+    return total;
+}
+
+static inline u32 largest_sum(u64 free_values, u32 k) {
+    u32 total = 0;
+    for (; k > 0 && free_values != 0; k--) {
+        u32 v = 63 - (u32)__builtin_clzll(free_values);
+        total += v;
+        free_values &= ~((u64)1 << v);
+    }
+    return total;
+}
+
+// values v in [lo, hi] as a bitmask
+static inline u64 range_mask(i32 lo, i32 hi) {
+    if (lo < 1) lo = 1;
+    if (hi > 63) hi = 63;
+    if (lo > hi) return 0;
+    u64 upto_hi = hi == 63 ? ~(u64)0 : ((u64)1 << (hi + 1)) - 1;
+    return upto_hi & ~(((u64)1 << lo) - 1);
+}
+
+// values that let a line with need left to fill and k more free cells after this one
+// still reach it: exactly need for its last cell, else a range from the extremes of
+// what k distinct free values can add up to
+static inline u64 line_mask(u64 others, i32 need, u32 k) {
+    if (k == 0) return range_mask(need, need);
+    return range_mask(need - (i32)largest_sum(others, k), need - (i32)smallest_sum(others, k));
+}
+
+// candidates for the next cell: free values that still let its row, its column and
+// any diagonal through it reach the magic sum, plus the symmetry-breaking order on
+// the corners (a[0][0] smallest corner, a[0][n-1] < a[n-1][0]) so each class of 8
+// rotations/reflections is found once
+static u64 candidates(const EnumShared* shared, const EnumTask* t) {
+    u32 n = shared->n;
+    i32 sum = (i32)shared->sum;
+    u32 d = t->depth;
+    u32 r = shared->order[d] / n, c = shared->order[d] % n;
+    u64 others = shared->all_values & ~t->used;
+    u64 free_values = others;
+
+    free_values &= line_mask(others, sum - (i32)t->row_sum[r], shared->rest_row[d]);
+    free_values &= line_mask(others, sum - (i32)t->col_sum[c], shared->rest_col[d]);
+    if (shared->rest_diagonal[d] != NOT_ON_LINE) {
+        free_values &= line_mask(others, sum - (i32)t->diagonal, shared->rest_diagonal[d]);
+    }
+    if (shared->rest_anti_diagonal[d] != NOT_ON_LINE) {
+        free_values &= line_mask(others, sum - (i32)t->anti_diagonal, shared->rest_anti_diagonal[d]);
+    }
+
+    // corners (each placed after the ones it is compared with):
+    // a[0][0] < a[0][n-1] < a[n-1][0], a[0][0] < a[n-1][n-1]
+    if (n > 1) {
+        u32 top_left = t->cells[0];
+        if (r == 0 && c == n - 1)     free_values &= range_mask((i32)top_left + 1, 63);
+        if (r == n - 1 && c == 0)     free_values &= range_mask((i32)t->cells[n - 1] + 1, 63);
+        if (r == n - 1 && c == n - 1) free_values &= range_mask((i32)top_left + 1, 63);
+    }
+    return free_values;
+}
+
+static void build_fill_order(EnumShared* shared) {
+    u32 n = shared->n;
+    u32 d = 0;
+    for (u32 i = 0; i < n; i++) {
+        for (u32 c = i; c < n; c++) shared->order[d++] = (u8)(i * n + c);
+        for (u32 r = i + 1; r < n; r++) shared->order[d++] = (u8)(r * n + i);
+    }
+
+    u32 cell_count = n * n;
+    for (d = 0; d < cell_count; d++) {
+        u32 r = shared->order[d] / n, c = shared->order[d] % n;
+        u32 rest_row = 0, rest_col = 0, rest_diagonal = 0, rest_anti_diagonal = 0;
+        for (u32 later = d + 1; later < cell_count; later++) {
+            u32 r2 = shared->order[later] / n, c2 = shared->order[later] % n;
+            rest_row += r2 == r;
+            rest_col += c2 == c;
+            rest_diagonal += r2 == c2;
+            rest_anti_diagonal += r2 + c2 == n - 1;
+        }
+        shared->rest_row[d] = (u8)rest_row;
+        shared->rest_col[d] = (u8)rest_col;
+        shared->rest_diagonal[d] = r == c ? (u8)rest_diagonal : NOT_ON_LINE;
+        shared->rest_anti_diagonal[d] = r + c == n - 1 ? (u8)rest_anti_diagonal : NOT_ON_LINE;
+    }
+}
+
+static inline void place(const EnumShared* shared, EnumTask* t, u32 v) {
+    u32 n = shared->n;
+    u32 cell = shared->order[t->depth];
+    u32 r = cell / n, c = cell % n;
+    t->cells[cell] = (u8)v;
+    t->row_sum[r] += v;
+    t->col_sum[c] += v;
+    if (r == c) t->diagonal += v;
+    if (r + c == n - 1) t->anti_diagonal += v;
+    t->used |= (u64)1 << v;
+    t->depth++;
+}
+
+static inline void unplace(const EnumShared* shared, EnumTask* t) {
+    u32 n = shared->n;
+    t->depth--;
+    u32 cell = shared->order[t->depth];
+    u32 r = cell / n, c = cell % n;
+    u32 v = t->cells[cell];
+    t->cells[cell] = 0;
+    t->row_sum[r] -= v;
+    t->col_sum[c] -= v;
+    if (r == c) t->diagonal -= v;
+    if (r + c == n - 1) t->anti_diagonal -= v;
+    t->used &= ~((u64)1 << v);
+}
+
+static void report(EnumWorker* w, const EnumTask* t) {
+    w->found++;
+    const EnumOptions* options = w->shared->options;
+    if (options->on_square != NULL) {
+        std::lock_guard<std::mutex> lock(w->shared->output);
+        options->on_square(w->shared->n, t->cells, options->user);
+    }
+}
+
+static inline void count_node(EnumWorker* w) {
+    if (++w->nodes == ENUM_NODE_BATCH) {
+        EnumShared* shared = w->shared;
+        u64 total = shared->nodes.fetch_add(w->nodes, std::memory_order_relaxed) + w->nodes;
+        w->nodes = 0;
+        if (shared->options->max_nodes != 0 && total >= shared->options->max_nodes) shared->stop = 1;
+    }
+}
+
+// plain depth-first search below t
+static void search(EnumWorker* w, EnumTask* t) {
+    EnumShared* shared = w->shared;
+    u32 cell_count = shared->n * shared->n;
+    if (t->depth == cell_count) {
+        report(w, t);
+        return;
+    }
+    if (shared->stop) return;
+
+    u64 options = candidates(shared, t);
+    while (options != 0) {
+        u32 v = (u32)__builtin_ctzll(options);
+        options &= options - 1;
+        count_node(w);
+        place(shared, t, v);
+        search(w, t);
+        unplace(shared, t);
+    }
+}
+
+static void push_task(EnumShared* shared, u32 owner, const EnumTask* t) {
+    shared->pending.fetch_add(1);
+    std::lock_guard<std::mutex> lock(shared->deques[owner]->mutex);
+    shared->deques[owner]->tasks.push_back(*t);
+    shared->queued.fetch_add(1);
+}
+
+// Wake the sleeping workers. Taking idle_mutex orders this after a waiter's check of
+// queued / pending, so a wakeup cannot slip in between its check and its sleep; and a
+// worker that went idle after idle was read here sees the new state in its check.
+static void wake_idle(EnumShared* shared) {
+    if (shared->idle.load() == 0) return;
+    { std::lock_guard<std::mutex> lock(shared->idle_mutex); }
+    shared->work_ready.notify_all();
+}
+
+// sleep until there may be a task to take; 0 once every task is done
+static bool_t wait_for_work(EnumShared* shared) {
+    std::unique_lock<std::mutex> lock(shared->idle_mutex);
+    shared->idle.fetch_add(1);
+    shared->work_ready.wait(lock, [shared] { return shared->queued.load() > 0 || shared->pending.load() == 0; });
+    shared->idle.fetch_sub(1);
+    return shared->pending.load() > 0;
+}
+
+// own deque from the back, else steal the oldest (biggest) task of another worker
+static bool_t take_task(EnumShared* shared, u32 id, EnumTask* out) {
+    u32 workers = (u32)shared->deques.size();
+    for (u32 k = 0; k < workers; k++) {
+        u32 victim = (id + k) % workers;
+        TaskDeque* deque = shared->deques[victim];
+        std::lock_guard<std::mutex> lock(deque->mutex);
+        if (deque->tasks.empty()) continue;
+        if (k == 0) {
+            *out = deque->tasks.back();
+            deque->tasks.pop_back();
+        } else {
+            *out = deque->tasks.front();
+            deque->tasks.pop_front();
+            shared->steals.fetch_add(1, std::memory_order_relaxed);
+        }
+        shared->queued.fetch_sub(1);
+        return 1;
+    }
+    return 0;
+}
+
+static void enum_worker(EnumShared* shared, u32 id) {
+    EnumWorker w;
+    w.shared = shared;
+    w.id = id;
+    w.nodes = 0;
+    w.found = 0;
+
+    EnumTask t;
+    for (;;) {
+        if (!take_task(shared, id, &t)) {
+            if (!wait_for_work(shared)) break;
+            continue;
+        }
+
+        // somebody is starving: split this task one level so the children can be stolen
+        if (shared->idle.load(std::memory_order_relaxed) > 0 && t.depth < ENUM_MAX_SPLIT && !shared->stop) {
+            u64 options = candidates(shared, &t);
+            while (options != 0) {
+                u32 v = (u32)__builtin_ctzll(options);
+                options &= options - 1;
+                count_node(&w);
+                place(shared, &t, v);
+                push_task(shared, id, &t);
+                unplace(shared, &t);
+            }
+            wake_idle(shared);
+        } else {
+            search(&w, &t);
+        }
+        shared->tasks_done.fetch_add(1, std::memory_order_relaxed);
+        if (shared->pending.fetch_sub(1) == 1) {
+            // the last task: let everyone still asleep see pending == 0 and leave
+            { std::lock_guard<std::mutex> lock(shared->idle_mutex); }
+            shared->work_ready.notify_all();
+        }
+    }
+
+    shared->nodes.fetch_add(w.nodes);
+    shared->found.fetch_add(w.found);
+}
+
+// every task at depth split, in search order
+static void expand_tasks(EnumShared* shared, EnumTask* t, u32 split, std::vector<EnumTask>* out) {
+    if (t->depth == split) {
+        out->push_back(*t);
+        return;
+    }
+    u64 options = candidates(shared, t);
+    while (options != 0) {
+        u32 v = (u32)__builtin_ctzll(options);
+        options &= options - 1;
+        place(shared, t, v);
+        expand_tasks(shared, t, split, out);
+        unplace(shared, t);
+    }
+}
+
+bool_t magic_enumerate(const EnumOptions* options, EnumStats* stats) {
+    u32 n = options->n;
+    if (n < 1 || n > ENUM_MAX_ORDER) return 0;
+
+    u32 threads = options->threads;
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    // default: the first row and one more cell fixed in each initial task
+    // (order 5: 1.7 M subtrees of about 10^7 nodes each)
+    u32 split = options->split_depth != 0 ? options->split_depth : n + 1;
+    if (split > n * n) split = n * n;
+
+    EnumShared shared;
+    shared.options = options;
+    shared.n = n;
+    shared.sum = (u32)magic_sum(n);
+    shared.all_values = range_mask(1, (i32)(n * n));
+    build_fill_order(&shared);
+    shared.pending = 0;
+    shared.queued = 0;
+    shared.idle = 0;
+    shared.stop = 0;
+    shared.nodes = 0;
+    shared.found = 0;
+    shared.steals = 0;
+    shared.tasks_done = 0;
+
+    double start = now_seconds();
+
+    // the initial frontier, optionally cut down to a random sample of subtrees
+    EnumTask root = {};
+    std::vector<EnumTask> frontier;
+    expand_tasks(&shared, &root, split, &frontier);
+    u64 subtrees = frontier.size();
+    if (options->sample != 0 && options->sample < frontier.size()) {
+        srand(options->seed);
+        for (u64 i = 0; i < options->sample; i++) {
+            u64 j = i + (u64)rand() % (frontier.size() - i);
+            EnumTask tmp = frontier[i];
+            frontier[i] = frontier[j];
+            frontier[j] = tmp;
+        }
+        frontier.resize(options->sample);
+    }
+
+    for (u32 i = 0; i < threads; i++) shared.deques.push_back(new TaskDeque());
+    for (u64 i = 0; i < frontier.size(); i++) push_task(&shared, (u32)(i % threads), &frontier[i]);
+
+    std::vector<std::thread> workers;
+    for (u32 i = 0; i < threads; i++) workers.emplace_back(enum_worker, &shared, i);
+
+    // progress, once a second, until the workers are done
+    double last = start;
+    while (shared.pending.load() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        double now = now_seconds();
+        if (options->progress && now - last >= 1.0) {
+            u64 nodes = shared.nodes.load();
+            fprintf(stderr, "  %.0f s: %llu nodes, %llu tasks done, %llu pending, %.2f M nodes/s\n",
+                    now - start, nodes, shared.tasks_done.load(), shared.pending.load(),
+                    (double)nodes / (now - start) / 1e6);
+            last = now;
+        }
+    }
+    for (std::thread& worker : workers) worker.join();
+    for (TaskDeque* deque : shared.deques) delete deque;
+
+    stats->seconds = now_seconds() - start;
+    stats->canonical = shared.found.load();
+    stats->total = stats->canonical * (n > 1 ? 8 : 1);
+    stats->nodes = shared.nodes.load();
+    stats->steals = shared.steals.load();
+    stats->subtrees = subtrees;
+    stats->subtrees_searched = frontier.size();
+    stats->stopped = shared.stop;
+    stats->complete = !shared.stop && frontier.size() == subtrees;
+    stats->estimate = frontier.size() > 0 ? (double)stats->canonical * subtrees / frontier.size() : 0.0;
+    return 1;
+}
+
+void print_enum_stats(u32 n, const EnumStats* stats) {
+    if (stats->complete) {
+        printf("Order %u: %llu magic squares, %llu up to rotation and reflection\n",
+               n, stats->total, stats->canonical);
+    } else if (stats->stopped) {
+        printf("Order %u (stopped at the node limit): %llu found so far up to symmetry\n",
+               n, stats->canonical);
+    } else {
+        printf("Order %u (partial, %llu of %llu subtrees): %llu found up to symmetry, about %.4g in all\n",
+               n, stats->subtrees_searched, stats->subtrees, stats->canonical, stats->estimate);
+    }
+    printf("%llu nodes in %.3f s (%.2f M nodes/s), %llu steals\n",
+           stats->nodes, stats->seconds, stats->seconds > 0 ? (double)stats->nodes / stats->seconds / 1e6 : 0.0,
+           stats->steals);
+}
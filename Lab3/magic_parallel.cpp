@@ -0,0 +1,103 @@
+#include "magic.h"
+#include "custom_types.h"
+#include <stdio.h>
+#include <time.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#define DEFAULT_TILE_BYTES (256 * 1024)     // about one L2 worth of rows per tile
+
+typedef struct {
+    u32* cells;
+    u32  n;
+    u32  rows_per_tile;
+    u32  tiles;
+    std::atomic<u32> next_tile;
+} TileQueue;
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void pin_to_cpu(u32 cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % CPU_SETSIZE, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+// take tiles until none are left; the pages of a tile are first touched here, so on
+// NUMA machines they land on the node of the thread that fills them
+static void tile_worker(TileQueue* queue, u32 cpu, bool_t pin) {
+    if (pin) pin_to_cpu(cpu);
+    for (;;) {
+        u32 tile = queue->next_tile.fetch_add(1, std::memory_order_relaxed);
+        if (tile >= queue->tiles) break;
+        u32 begin = tile * queue->rows_per_tile;
+        u32 end = begin + queue->rows_per_tile;
+        if (end > queue->n) end = queue->n;
+        magic_fill_rows(queue->n, queue->cells, begin, end);
+    }
+}
+
+static void fill_tiles(u32 n, u32 cells[], const MagicBuildOptions* options, MagicBuildStats* stats, double start) {
+    u32 threads = options != NULL ? options->threads : 0;
+    u32 tile_bytes = options != NULL && options->tile_bytes > 0 ? options->tile_bytes : DEFAULT_TILE_BYTES;
+    bool_t pin = options != NULL && options->pin;
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    TileQueue queue;
+    queue.cells = cells;
+    queue.n = n;
+    u64 row_bytes = (u64)n * sizeof(u32);
+    queue.rows_per_tile = row_bytes >= tile_bytes ? 1 : (u32)(tile_bytes / row_bytes);
+    queue.tiles = (n + queue.rows_per_tile - 1) / queue.rows_per_tile;
+    queue.next_tile = 0;
+    if (threads > queue.tiles) threads = queue.tiles;
+
+    // the calling thread works too
+    std::vector<std::thread> workers;
+    for (u32 i = 1; i < threads; i++) {
+        workers.emplace_back(tile_worker, &queue, i, pin);
+    }
+    tile_worker(&queue, 0, pin);
+    for (std::thread& worker : workers) worker.join();
+
+    if (stats != NULL) {
+        stats->seconds = now_seconds() - start;
+        stats->cells_per_sec = stats->seconds > 0 ? (double)n * n / stats->seconds : 0.0;
+        stats->threads = threads;
+        stats->tiles = queue.tiles;
+    }
+}
+
+void magic_fill_parallel(u32 n, u32 cells[], const MagicBuildOptions* options, MagicBuildStats* stats) {
+    fill_tiles(n, cells, options, stats, now_seconds());
+}
+
+bool_t magic_build_parallel(MagicSquare* square, u32 n, const MagicBuildOptions* options, MagicBuildStats* stats) {
+    double start = now_seconds();
+    if (!magic_alloc(square, n)) return 0;
+    fill_tiles(n, square->cells, options, stats, start);
+    return 1;
+}
+
+void print_build_stats(u32 n, const MagicBuildStats* stats) {
+    printf("Built %u x %u magic square in %.3f s (%u threads, %u tiles)\n",
+           n, n, stats->seconds, stats->threads, stats->tiles);
+    printf("%.1f M cells/s, %.2f GB/s\n",
+           stats->cells_per_sec / 1e6, stats->cells_per_sec * sizeof(u32) / 1e9);
+}
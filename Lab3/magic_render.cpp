@@ -0,0 +1,115 @@
+#include "magic.h"
+#include "custom_types.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+// append to the frame, growing the buffer if a full frame does not fit
+static void emit(SquareRenderer* r, const char* format, ...) {
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        i32 written = vsnprintf(r->buf + r->len, r->cap - r->len, format, args);
+        va_end(args);
+        if (written < 0) return;
+        if ((u32)written < r->cap - r->len) {
+            r->len += (u32)written;
+            return;
+        }
+
+        u32 cap = r->cap * 2;
+        while (cap - r->len <= (u32)written) cap *= 2;
+        char* bigger = (char*)realloc(r->buf, cap);
+        if (bigger == NULL) return;                 // drop it, the next full frame repairs the screen
+        r->buf = bigger;
+        r->cap = cap;
+    }
+}
+
+// one write and one flush per frame
+static void flush_frame(SquareRenderer* r) {
+    if (r->len == 0) return;
+    fwrite(r->buf, 1, r->len, stdout);
+    fflush(stdout);
+    r->bytes_written += r->len;
+    r->frames++;
+    r->len = 0;
+}
+
+bool_t renderer_init(SquareRenderer* r, u32 n) {
+    r->n = n;
+    r->width = 1;
+    for (u64 temp = (u64)n * n; temp >= 10; temp /= 10) r->width++;
+    r->width += 1;
+    r->drawn = 0;
+    r->len = 0;
+    r->frames = 0;
+    r->bytes_written = 0;
+    r->shown = (u32*)calloc((size_t)n * n, sizeof(u32));
+    r->buf = (char*)malloc(RENDER_BUF_BYTES);
+    r->cap = RENDER_BUF_BYTES;
+    if (r->shown == NULL || r->buf == NULL) {
+        renderer_free(r);
+        return 0;
+    }
+    return 1;
+}
+
+void renderer_free(SquareRenderer* r) {
+    free(r->shown);
+    free(r->buf);
+    r->shown = NULL;
+    r->buf = NULL;
+    r->cap = 0;
+    r->len = 0;
+}
+
+static void emit_cell(SquareRenderer* r, u32 value) {
+    if (value == 0) {
+        emit(r, "%*s", r->width, "");
+    } else {
+        emit(r, "%*u", r->width, value);
+    }
+}
+
+// full frame, same layout as print_square; the cursor ends up below the grid
+static void draw_full(SquareRenderer* r, const u32 cells[]) {
+    u32 n = r->n;
+    emit(r, "--- Magic Square N=%u ---\n", n);
+    for (u32 i = 0; i < n; i++) {
+        emit(r, "  ");
+        for (u32 j = 0; j < n; j++) {
+            u64 k = (u64)i * n + j;
+            emit_cell(r, cells[k]);
+            r->shown[k] = cells[k];
+        }
+        emit(r, "\n");
+    }
+    emit(r, "-------------------------\n");
+    r->drawn = 1;
+}
+
+void renderer_present(SquareRenderer* r, const MagicSquare* square) {
+    if (square->n != r->n) return;
+    if (!r->drawn) {
+        draw_full(r, square->cells);
+        flush_frame(r);
+        return;
+    }
+
+    // only the cells that changed: save the cursor (below the grid), go up to the
+    // cell's line and over to its column, write it, restore
+    u32 n = r->n;
+    for (u32 i = 0; i < n; i++) {
+        const u32* row = square->cells + (u64)i * n;
+        u32* shown = r->shown + (u64)i * n;
+        for (u32 j = 0; j < n; j++) {
+            if (row[j] == shown[j]) continue;
+            emit(r, "\0337\033[%uA\033[%uG", n + 1 - i, 3 + j * (u32)r->width);
+            emit_cell(r, row[j]);
+            emit(r, "\0338");
+            shown[j] = row[j];
+        }
+    }
+    flush_frame(r);
+}
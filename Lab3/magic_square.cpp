@@ -45,16 +45,17 @@ void print_square(i32 n, u32 square[MAX_N][MAX_N]) {
 }
 
 void generate_magic(i32 n) {
-    if (n > MAX_N) {
-        n = MAX_N;
+    MagicSquare square;
+    SquareRenderer renderer;
+    if (!magic_alloc(&square, (u32)n) || !renderer_init(&renderer, (u32)n)) {
+        printf("Error: not enough memory for N=%d.\n", n);
+        magic_free(&square);
+        return;
     }
 
-    u32 square[MAX_N][MAX_N];
-
-    for (i32 i = 0; i < n; i++) {
-        for (i32 j = 0; j < n; j++) {
-            square[i][j] = 0;
-        }
+    u32* cells = square.cells;
+    for (u64 k = 0; k < (u64)n * n; k++) {
+        cells[k] = 0;
     }
 
     i32 row = 0;
@@ -63,11 +64,11 @@ void generate_magic(i32 n) {
     u32 total_cells = n * n;
 
     printf("Starting %d x %d magic square...\n", n, n);
-    print_square(n, square);
+    renderer_present(&renderer, &square);
 
     for (u32 k = 1; k <= total_cells; k++) {
-        square[row][col] = k;
-        print_square(n, square);
+        cells[(u64)row * n + col] = k;
+        renderer_present(&renderer, &square);
         delay_ms(DELAY_MS);
 
         next_row = row - 1;
@@ -78,7 +79,7 @@ void generate_magic(i32 n) {
 
         if (k % n == 0) {
             row = (row + 1) % n;
-        } else if (square[wrapped_row][wrapped_col] != 0) {
+        } else if (cells[(u64)wrapped_row * n + wrapped_col] != 0) {
             row = (row + 1) % n;
         } else {
             row = wrapped_row;
@@ -87,6 +88,177 @@ void generate_magic(i32 n) {
     }
 
     printf("\n--- Done ---\n");
-    i32 magic_sum = n * (n * n + 1) / 2;
-    printf("Magic sum: %d\n", magic_sum);
+    printf("Rendered %u frames in %llu bytes\n", renderer.frames, renderer.bytes_written);
+    printf("Magic sum: %llu\n", magic_sum((u32)n));
+
+    renderer_free(&renderer);
+    magic_free(&square);
+}
+
+// --- any-order construction ---
+
+bool_t magic_order_supported(u32 n) {
+    return n >= 1 && n != 2 && n <= MAGIC_MAX_ORDER;
+}
+
+u64 magic_sum(u32 n) {
+    return (u64)n * ((u64)n * n + 1) / 2;
+}
+
+// Siamese square (start at the top middle, step up-right, drop down on a collision)
+// in closed form: value - 1 = n * ((row + col + n/2 + 1) % n) + (row + 2*col + 1) % n
+static inline u32 odd_cell(u32 n, u32 row, u32 col) {
+    return n * ((row + col + n / 2 + 1) % n) + (row + 2 * col + 1) % n + 1;
+}
+
+// one row of the Siamese square; along a row both terms just count up (by 1 and by 2)
+// and wrap, so the row is a few runs where each value is the previous one + n + 2.
+// The runs are plain arithmetic sequences, which the compiler vectorizes.
+static void odd_fill_row(u32 n, u32 row, u32 out[]) {
+    u32 hi = (row + n / 2 + 1) % n;
+    u32 lo = (row + 1) % n;
+    u32 col = 0;
+    while (col < n) {
+        u32 run = n - hi;                       // steps until hi wraps
+        u32 lo_run = (n - lo + 1) / 2;          // steps until lo wraps
+        if (lo_run < run) run = lo_run;
+        if (n - col < run) run = n - col;
+
+        u32 value = n * hi + lo + 1;
+        for (u32 k = 0; k < run; k++) {
+            out[col + k] = value + k * (n + 2);
+        }
+        col += run;
+        hi += run;
+        if (hi >= n) hi -= n;
+        lo += 2 * run;
+        if (lo >= n) lo -= n;
+    }
+}
+
+// 1..n*n in reading order, complemented (n*n + 1 - k) on both diagonals of every 4x4 block
+static inline bool_t doubly_even_flipped(u32 row, u32 col) {
+    u32 r = row & 3, c = col & 3;
+    return r == c || r + c == 3;
+}
+
+// n is a multiple of 4, so the row is whole groups of 4 with the same two flipped columns
+static void doubly_even_fill_row(u32 n, u32 row, u32 out[]) {
+    u32 first = row * n + 1;
+    u32 flip = n * n + 1;
+    u32 a = row & 3, b = 3 - (row & 3);
+    for (u32 col = 0; col < n; col += 4) {
+        for (u32 c = 0; c < 4; c++) {
+            u32 k = first + col + c;
+            out[col + c] = (c == a || c == b) ? flip - k : k;
+        }
+    }
+}
+
+// LUX: each cell of the odd square of order m2 = n/2 becomes a 2x2 block holding
+// 4*(v-1) + 1..4 in the order of its letter. Block rows 0..m are L, row m+1 is U,
+// the rest X, and the middle U trades places with the L above it.
+//   L: 4 1    U: 1 4    X: 1 4
+//      2 3       2 3       3 2
+static const u8 lux_offset[3][2][2] = {
+    { { 4, 1 }, { 2, 3 } },     // L
+    { { 1, 4 }, { 2, 3 } },     // U
+    { { 1, 4 }, { 3, 2 } }      // X
+};
+
+static inline u32 lux_letter(u32 m, u32 block_row, u32 block_col) {
+    if (block_col == m && block_row == m)     return 1;    // swapped: U
+    if (block_col == m && block_row == m + 1) return 0;    // swapped: L
+    if (block_row <= m)     return 0;
+    if (block_row == m + 1) return 1;
+    return 2;
+}
+
+static void singly_even_fill_row(u32 n, u32 row, u32 out[]) {
+    u32 m2 = n / 2;
+    u32 m = m2 / 2;
+    u32 block_row = row / 2;
+    u32 half = row & 1;
+
+    // the odd square's row, stepped the same way as odd_fill_row
+    u32 hi = (block_row + m2 / 2 + 1) % m2;
+    u32 lo = (block_row + 1) % m2;
+    for (u32 block_col = 0; block_col < m2; block_col++) {
+        u32 base = 4 * (m2 * hi + lo);
+        const u8* offset = lux_offset[lux_letter(m, block_row, block_col)][half];
+        out[2 * block_col]     = base + offset[0];
+        out[2 * block_col + 1] = base + offset[1];
+        if (++hi == m2) hi = 0;
+        lo += 2;
+        if (lo >= m2) lo -= m2;
+    }
+}
+
+u32 magic_cell(u32 n, u32 row, u32 col) {
+    if (n % 2 == 1) return odd_cell(n, row, col);
+    if (n % 4 == 0) {
+        u32 k = row * n + col + 1;
+        return doubly_even_flipped(row, col) ? n * n + 1 - k : k;
+    }
+    u32 m2 = n / 2;
+    u32 block_row = row / 2, block_col = col / 2;
+    u32 v = odd_cell(m2, block_row, block_col);
+    return 4 * (v - 1) + lux_offset[lux_letter(m2 / 2, block_row, block_col)][row & 1][col & 1];
+}
+
+void magic_fill_row(u32 n, u32 row, u32 out[]) {
+    if (n % 2 == 1) {
+        odd_fill_row(n, row, out);
+    } else if (n % 4 == 0) {
+        doubly_even_fill_row(n, row, out);
+    } else {
+        singly_even_fill_row(n, row, out);
+    }
+}
+
+void magic_fill_rows(u32 n, u32 cells[], u32 row_begin, u32 row_end) {
+    for (u32 row = row_begin; row < row_end; row++) {
+        magic_fill_row(n, row, cells + (u64)row * n);
+    }
+}
+
+bool_t magic_alloc(MagicSquare* square, u32 n) {
+    square->n = 0;
+    square->cells = NULL;
+    if (!magic_order_supported(n)) return 0;
+
+    square->cells = (u32*)malloc((size_t)n * n * sizeof(u32));
+    if (square->cells == NULL) return 0;
+    square->n = n;
+    return 1;
+}
+
+bool_t magic_build(MagicSquare* square, u32 n) {
+    if (!magic_alloc(square, n)) return 0;
+    magic_fill_rows(n, square->cells, 0, n);
+    return 1;
+}
+
+void magic_free(MagicSquare* square) {
+    free(square->cells);
+    square->cells = NULL;
+    square->n = 0;
+}
+
+void print_magic(const MagicSquare* square) {
+    u32 n = square->n;
+    i32 width = 1;
+    for (u64 temp = (u64)n * n; temp >= 10; temp /= 10) width++;
+    width += 1;
+
+    printf("--- Magic Square N=%u ---\n", n);
+    for (u32 i = 0; i < n; i++) {
+        printf("  ");
+        for (u32 j = 0; j < n; j++) {
+            printf("%*u", width, square->cells[(u64)i * n + j]);
+        }
+        printf("\n");
+    }
+    printf("-------------------------\n");
+    printf("Magic sum: %llu\n", magic_sum(n));
 }
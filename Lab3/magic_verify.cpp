@@ -0,0 +1,242 @@
+#include "magic.h"
+#include "custom_types.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <thread>
+#include <vector>
+
+#define VERIFY_MIN_CELLS_PER_THREAD (1u << 20)
+
+// one per thread: a band of whole rows, its own column sums and its own bitset
+typedef struct {
+    u32  row_begin;
+    u32  row_end;
+    u64* col_sums;                  // n entries
+    u64* seen;                      // bit v - 1 set once value v was met in this band
+    u64  diagonal;
+    u64  anti_diagonal;
+    bool_t values_bad;              // a value outside 1..n*n, located afterwards
+    MagicCheck first;               // first bad row in this band
+    u64  word_begin;                // merge: this thread's slice of the bitsets
+    u64  word_end;
+    u64  distinct;                  // merge: values in the slice seen at least once
+} VerifyBand;
+
+typedef struct {
+    u32 n;
+    const u32* cells;
+    u64 sum;
+    std::vector<VerifyBand>* bands;
+} VerifyJob;
+
+static void set_violation(MagicCheck* check, MagicViolation kind, u32 row, u32 col, u64 expected, u64 actual) {
+    check->kind = kind;
+    check->row = row;
+    check->col = col;
+    check->expected = expected;
+    check->actual = actual;
+}
+
+// column sums as n independent lanes: each row is added to the accumulator row
+// element by element, a contiguous loop the compiler turns into vector adds
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(__clang__)
+__attribute__((target_clones("avx2", "default")))
+#endif
+static u64 add_row(u64 col_sums[], const u32 row[], u32 n) {
+    u64 total = 0;
+    for (u32 col = 0; col < n; col++) {
+        col_sums[col] += row[col];
+        total += row[col];
+    }
+    return total;
+}
+
+static void verify_band(const VerifyJob* job, VerifyBand* band) {
+    u32 n = job->n;
+    u64 cell_count = (u64)n * n;
+    u64* seen = band->seen;
+
+    for (u32 row = band->row_begin; row < band->row_end; row++) {
+        const u32* cells = job->cells + (u64)row * n;
+        u64 total = add_row(band->col_sums, cells, n);
+        band->diagonal += cells[row];
+        band->anti_diagonal += cells[n - 1 - row];
+        if (total != job->sum && band->first.kind == MAGIC_OK) {
+            set_violation(&band->first, MAGIC_BAD_ROW, row, 0, job->sum, total);
+        }
+
+        // mark the values in this thread's own bitset: plain stores, nothing shared.
+        // Repeats are not looked for here, the merge counts distinct values instead.
+        if (band->values_bad) continue;
+        for (u32 col = 0; col < n; col++) {
+            u64 index = (u64)cells[col] - 1;
+            if (index >= cell_count) {
+                band->values_bad = 1;
+                break;
+            }
+            seen[index >> 6] |= (u64)1 << (index & 63);
+        }
+    }
+}
+
+// OR one slice of every band's bitset together and count the values seen
+static void merge_seen(const VerifyJob* job, VerifyBand* band) {
+    const std::vector<VerifyBand>& bands = *job->bands;
+    u64 distinct = 0;
+    for (u64 k = band->word_begin; k < band->word_end; k++) {
+        u64 word = 0;
+        for (const VerifyBand& other : bands) word |= other.seen[k];
+        distinct += (u64)__builtin_popcountll(word);
+    }
+    band->distinct = distinct;
+}
+
+// Slow path once the fast pass found a bad value: one thread, in reading order, so
+// the report is the first out-of-range value or the first repeat of an earlier one.
+static MagicCheck first_bad_value(u32 n, const u32 cells[], u64 seen[]) {
+    MagicCheck check;
+    set_violation(&check, MAGIC_OK, 0, 0, 0, 0);
+    u64 cell_count = (u64)n * n;
+    for (u64 k = 0; k < cell_count; k++) {
+        u64 value = cells[k];
+        u32 row = (u32)(k / n), col = (u32)(k % n);
+        if (value == 0 || value > cell_count) {
+            set_violation(&check, MAGIC_OUT_OF_RANGE, row, col, cell_count, value);
+            return check;
+        }
+        u64 bit = (u64)1 << ((value - 1) & 63);
+        if (seen[(value - 1) >> 6] & bit) {
+            set_violation(&check, MAGIC_DUPLICATE, row, col, 1, value);
+            return check;
+        }
+        seen[(value - 1) >> 6] |= bit;
+    }
+    return check;
+}
+
+template <typename Step>
+static void run_bands(const VerifyJob* job, Step step) {
+    std::vector<VerifyBand>& bands = *job->bands;
+    std::vector<std::thread> workers;
+    for (u32 t = 1; t < bands.size(); t++) {
+        workers.emplace_back(step, job, &bands[t]);
+    }
+    step(job, &bands[0]);
+    for (std::thread& worker : workers) worker.join();
+}
+
+MagicCheck magic_verify(u32 n, const u32 cells[], u32 threads) {
+    MagicCheck check;
+    set_violation(&check, MAGIC_OK, 0, 0, 0, 0);
+    if (n == 0) return check;
+
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    u64 cell_count = (u64)n * n;
+    u64 by_size = cell_count / VERIFY_MIN_CELLS_PER_THREAD;
+    if (by_size < threads) threads = by_size > 0 ? (u32)by_size : 1;
+    if (threads > n) threads = n;
+
+    // one bitset per thread (n * n / 8 bytes each); fall back to fewer threads if
+    // that much memory is not there
+    u64 words = (cell_count + 63) / 64;
+    u64* seen = NULL;
+    while (threads > 1 && (seen = (u64*)calloc((size_t)threads * words, sizeof(u64))) == NULL) threads /= 2;
+    if (seen == NULL) seen = (u64*)calloc((size_t)words, sizeof(u64));
+    if (seen == NULL) throw std::bad_alloc();   // as new[] would
+
+    std::vector<u64> col_sums((u64)threads * n, 0);
+    std::vector<VerifyBand> bands(threads);
+    for (u32 t = 0; t < threads; t++) {
+        bands[t].row_begin = (u32)((u64)n * t / threads);
+        bands[t].row_end = (u32)((u64)n * (t + 1) / threads);
+        bands[t].col_sums = col_sums.data() + (u64)t * n;
+        bands[t].seen = seen + (u64)t * words;
+        bands[t].diagonal = 0;
+        bands[t].anti_diagonal = 0;
+        bands[t].values_bad = 0;
+        set_violation(&bands[t].first, MAGIC_OK, 0, 0, 0, 0);
+        bands[t].word_begin = words * t / threads;
+        bands[t].word_end = words * (t + 1) / threads;
+        bands[t].distinct = 0;
+    }
+
+    VerifyJob job;
+    job.n = n;
+    job.cells = cells;
+    job.sum = magic_sum(n);
+    job.bands = &bands;
+
+    run_bands(&job, verify_band);
+
+    // a permutation of 1..n*n: every value in range and n*n of them distinct
+    bool_t values_bad = 0;
+    for (const VerifyBand& band : bands) values_bad |= band.values_bad;
+    if (!values_bad) {
+        run_bands(&job, merge_seen);
+        u64 distinct = 0;
+        for (const VerifyBand& band : bands) distinct += band.distinct;
+        values_bad = distinct != cell_count;
+    }
+    if (values_bad) {
+        memset(seen, 0, (size_t)words * sizeof(u64));
+        check = first_bad_value(n, cells, seen);
+    }
+    free(seen);
+    if (check.kind != MAGIC_OK) return check;
+
+    // then rows, in reading order (bands are in row order)
+    for (u32 t = 0; t < threads; t++) {
+        if (bands[t].first.kind == MAGIC_BAD_ROW) return bands[t].first;
+    }
+
+    // merge the column lanes
+    u64 diagonal = 0, anti_diagonal = 0;
+    for (u32 t = 1; t < threads; t++) {
+        for (u32 col = 0; col < n; col++) col_sums[col] += bands[t].col_sums[col];
+    }
+    for (u32 t = 0; t < threads; t++) {
+        diagonal += bands[t].diagonal;
+        anti_diagonal += bands[t].anti_diagonal;
+    }
+    for (u32 col = 0; col < n; col++) {
+        if (col_sums[col] != job.sum) {
+            set_violation(&check, MAGIC_BAD_COLUMN, 0, col, job.sum, col_sums[col]);
+            return check;
+        }
+    }
+    if (diagonal != job.sum) {
+        set_violation(&check, MAGIC_BAD_DIAGONAL, 0, 0, job.sum, diagonal);
+    } else if (anti_diagonal != job.sum) {
+        set_violation(&check, MAGIC_BAD_ANTI_DIAGONAL, 0, n - 1, job.sum, anti_diagonal);
+    }
+    return check;
+}
+
+void print_check(const MagicCheck* check) {
+    switch (check->kind) {
+        case MAGIC_OK:
+            printf("Verified: magic square.\n");
+            break;
+        case MAGIC_BAD_ROW:
+            printf("Not magic: row %u sums to %llu, expected %llu.\n", check->row, check->actual, check->expected);
+            break;
+        case MAGIC_BAD_COLUMN:
+            printf("Not magic: column %u sums to %llu, expected %llu.\n", check->col, check->actual, check->expected);
+            break;
+        case MAGIC_BAD_DIAGONAL:
+            printf("Not magic: main diagonal sums to %llu, expected %llu.\n", check->actual, check->expected);
+            break;
+        case MAGIC_BAD_ANTI_DIAGONAL:
+            printf("Not magic: anti-diagonal sums to %llu, expected %llu.\n", check->actual, check->expected);
+            break;
+        case MAGIC_OUT_OF_RANGE:
+            printf("Not magic: cell (%u, %u) holds %llu, outside 1..%llu.\n", check->row, check->col, check->actual, check->expected);
+            break;
+        case MAGIC_DUPLICATE:
+            printf("Not magic: cell (%u, %u) repeats the value %llu.\n", check->row, check->col, check->actual);
+            break;
+    }
+}
@@ -1,29 +1,61 @@
 #include "magic.h"
 #include "custom_types.h"
 #include <stdio.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+// can the order-n animation be drawn in place: the renderer moves the cursor up over
+// the grid, which only works while the whole grid is on screen (unknown size: up to MAX_N)
+static bool_t fits_terminal(i32 n) {
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || size.ws_row == 0 || size.ws_col == 0) return n <= MAX_N;
+    i32 width = 2;
+    for (i64 temp = (i64)n * n; temp >= 10; temp /= 10) width++;
+    return n + 3 <= size.ws_row && 2 + (i64)n * width <= size.ws_col;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        return run_batch(argc, argv);
+    }
 
-int main() {
     i32 n;
 
     printf("Magic Square Generator\n");
-    printf("Enter ODD N (max %d): ", MAX_N);
+    printf("Enter N (odd N that fits the terminal is animated): ");
 
     if (scanf("%d", &n) != 1) {
         printf("Invalid input.\n");
         return 1;
     }
 
-    if (n <= 0 || n % 2 == 0) {
-        printf("Error: N must be positive and ODD.\n");
+    if (n <= 0 || !magic_order_supported((u32)n)) {
+        printf("Error: N must be 1 or 3..%d.\n", MAGIC_MAX_ORDER);
+        return 1;
+    }
+
+    if (n % 2 == 1 && fits_terminal(n)) {
+        generate_magic(n);
+        return 0;
+    }
+
+    MagicSquare square;
+    MagicBuildStats stats;
+    if (!magic_build_parallel(&square, (u32)n, NULL, &stats)) {
+        printf("Error: not enough memory for N=%d.\n", n);
         return 1;
     }
 
-    if (n > MAX_N) {
-        printf("N too big, using %d.\n", MAX_N);
-        n = MAX_N;
+    if (n <= MAX_N) {
+        print_magic(&square);
+    } else {
+        print_build_stats((u32)n, &stats);
+        printf("Magic sum: %llu\n", magic_sum((u32)n));
     }
 
-    generate_magic(n);
+    MagicCheck check = magic_verify(square.n, square.cells, 0);
+    print_check(&check);
 
+    magic_free(&square);
     return 0;
 }
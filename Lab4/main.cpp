@@ -1,9 +1,11 @@
 #include "string_lib.h"
 #include <iostream>
+#include <chrono>
+#include <utility>
 
 int main() {
-    char str1[50] = "Hello, ";
-    char str2[] = "World!";
+    u8 str1[50] = "Hello, ";
+    u8 str2[] = "World!";
     
     std::cout << "String 1: " << str1 << std::endl;
     std::cout << "String 2: " << str2 << std::endl;
@@ -27,13 +29,50 @@ int main() {
     std::cout << "String 2 to Lowercase: " << str2 << std::endl;
 
     // Test str_concat
-    str_concat(str1, str2, len1);
+    str_concat(str1, str2, sizeof(str1));
     std::cout << "Concatenated String: " << str1 << std::endl;
 
     // Test str_copy
-    char str3[50];
-    str_copy(str3, str1, len1 + string_length(str2));
+    u8 str3[50];
+    str_copy(str3, str1, sizeof(str3));
     std::cout << "Copied String: " << str3 << std::endl;
 
+    // Test utf8_to_upper / utf8_to_lower: accented Greek keeps its accents
+    u8 name[] = "Γιώργος Όλγα Ήρα Ύβη Ρωμαϊκή µ";
+    u8 upper_name[] = "ΓΙΏΡΓΟΣ ΌΛΓΑ ΉΡΑ ΎΒΗ ΡΩΜΑΪΚΉ Μ";
+    u8 lower_name[] = "γιώργοσ όλγα ήρα ύβη ρωμαϊκή μ";
+    u32 name_len = string_length(name);
+    u8 converted[sizeof(name)] = {};
+    utf8_to_upper(converted, name, name_len);
+    std::cout << "UTF-8 to Uppercase: " << converted
+              << (str_cmp(converted, upper_name) == 0 ? " (ok)" : " (WRONG)") << std::endl;
+    utf8_to_lower(converted, converted, name_len);
+    std::cout << "UTF-8 to Lowercase: " << converted
+              << (str_cmp(converted, lower_name) == 0 ? " (ok)" : " (WRONG)") << std::endl;
+
+    // Test StrBuilder: the same concat, without fixed sizes
+    StrBuilder line;
+    line.append(str1);
+    line.append((u8*)" + builder");
+    std::cout << "Builder String: " << line.c_str() << " (" << line.length() << " bytes)" << std::endl;
+
+    // Test StrBuilder: 10^7 fragments, linear time because appends are amortized O(1)
+    u8 fragment[] = "abc,";
+    StrView piece = str_view(fragment);
+    const u32 fragment_count = 10000000;
+
+    auto start = std::chrono::steady_clock::now();
+    StrBuilder big;
+    for (u32 i = 0; i < fragment_count; i++) {
+        big.append(piece);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Builder appended " << fragment_count << " fragments: "
+              << big.length() << " bytes in " << ms << " ms" << std::endl;
+
+    // the builder's view works with the plain u8[] functions
+    StrBuilder moved = std::move(big);
+    std::cout << "Length check: " << string_length(moved.c_str()) << std::endl;
+
     return 0;
-}
\ No newline at end of file
+}
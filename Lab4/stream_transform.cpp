@@ -0,0 +1,266 @@
+// Streams a file of any size through a string_lib transform with constant memory.
+// build: g++ -O2 -std=c++17 -pthread stream_transform.cpp string_lib.cpp string_search.cpp string_number.cpp string_hash.cpp string_utf8.cpp string_token.cpp -o stream_transform
+//
+// usage: stream_transform [-j threads] [-b block_kb] upper|lower|fold <input> <output>
+//        stream_transform [-j threads] [-b block_kb] count <input> <pattern>
+//
+// Three stages joined by bounded queues:
+//   1. reader  - reads large aligned blocks into buffers taken from a fixed pool
+//   2. workers - run the vectorized kernel on each block
+//   3. writer  - writes blocks back in input order and returns them to the pool
+// The pool size never changes, so memory use does not depend on the input size.
+
+#include "string_lib.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+
+#define BLOCK_ALIGN      4096
+#define DEFAULT_BLOCK_KB 4096
+
+enum TransformMode { MODE_UPPER, MODE_LOWER, MODE_FOLD, MODE_COUNT };
+
+typedef struct {
+    u8* data;           // aligned: prefix bytes, then up to block_size bytes read
+    u32 prefix;         // bytes carried over from the previous block (count mode)
+    u32 len;            // bytes read into this block after the prefix
+    u64 index;          // position in the input, blocks are written in this order
+    u64 matches;
+} Block;
+
+// blocking FIFO of block pointers, close() wakes everybody up once it is drained
+class BlockQueue {
+public:
+    void push(Block* block) {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push_back(block);
+        ready.notify_one();
+    }
+
+    // nullptr once the queue is closed and empty
+    Block* pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return !items.empty() || closed; });
+        if (items.empty()) return nullptr;
+        Block* block = items.front();
+        items.pop_front();
+        return block;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        ready.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Block*> items;
+    bool closed = false;
+};
+
+typedef struct {
+    TransformMode mode;
+    FILE* in;
+    FILE* out;
+    u8*   pattern;
+    u32   pattern_len;
+    u32   block_size;
+    u32   threads;
+    std::atomic<bool_t> failed;
+} Pipeline;
+
+// stage 1: fill free blocks from the input, in order
+static void read_stage(Pipeline* p, BlockQueue* free_blocks, BlockQueue* work) {
+    u32 overlap = p->mode == MODE_COUNT && p->pattern_len > 0 ? p->pattern_len - 1 : 0;
+    std::vector<u8> carry(overlap);
+    u32 carried = 0;
+
+    for (u64 index = 0;; index++) {
+        Block* block = free_blocks->pop();
+        if (block == nullptr) break;
+
+        // a match may straddle two blocks: start this one with the previous tail
+        memcpy(block->data, carry.data(), carried);
+        block->prefix = carried;
+        block->len = (u32)fread(block->data + carried, 1, p->block_size, p->in);
+        block->index = index;
+        block->matches = 0;
+
+        if (block->len == 0) {
+            if (ferror(p->in)) p->failed = 1;
+            free_blocks->push(block);
+            break;
+        }
+
+        u32 total = block->prefix + block->len;
+        carried = total < overlap ? total : overlap;
+        memcpy(carry.data(), block->data + total - carried, carried);
+
+        work->push(block);
+    }
+    work->close();
+}
+
+// stage 2: run the kernel on each block, in any order
+static void work_stage(Pipeline* p, BlockQueue* work, BlockQueue* done) {
+    for (;;) {
+        Block* block = work->pop();
+        if (block == nullptr) break;
+
+        u8* text = block->data + block->prefix;
+        switch (p->mode) {
+            case MODE_UPPER: to_uppercase_n(text, block->len); break;
+            case MODE_LOWER: to_lowercase_n(text, block->len); break;
+            case MODE_FOLD:  case_fold_copy(text, text, block->len); break;
+            case MODE_COUNT:
+                block->matches = str_find_all(block->data, block->prefix + block->len,
+                                              p->pattern, p->pattern_len, nullptr, nullptr);
+                break;
+        }
+        done->push(block);
+    }
+}
+
+// stage 3: put finished blocks back in input order, write them, recycle them
+static u64 write_stage(Pipeline* p, BlockQueue* done, BlockQueue* free_blocks, u32 pool_size) {
+    std::vector<Block*> pending(pool_size, nullptr);     // at most pool_size blocks in flight
+    u64 next = 0;
+    u64 matches = 0;
+
+    for (;;) {
+        Block* block = done->pop();
+        if (block == nullptr) break;
+        pending[block->index % pool_size] = block;
+
+        while (pending[next % pool_size] != nullptr && pending[next % pool_size]->index == next) {
+            Block* ready = pending[next % pool_size];
+            pending[next % pool_size] = nullptr;
+
+            if (p->mode == MODE_COUNT) {
+                matches += ready->matches;
+            } else if (fwrite(ready->data + ready->prefix, 1, ready->len, p->out) != ready->len) {
+                p->failed = 1;
+            }
+            free_blocks->push(ready);
+            next++;
+        }
+    }
+    return matches;
+}
+
+static void usage() {
+    printf("usage: stream_transform [-j threads] [-b block_kb] upper|lower|fold <input> <output>\n");
+    printf("       stream_transform [-j threads] [-b block_kb] count <input> <pattern>\n");
+}
+
+int main(int argc, char* argv[]) {
+    Pipeline p;
+    p.threads = std::thread::hardware_concurrency();
+    if (p.threads == 0) p.threads = 2;
+    p.block_size = DEFAULT_BLOCK_KB * 1024;
+    p.pattern = nullptr;
+    p.pattern_len = 0;
+    p.in = nullptr;
+    p.out = nullptr;
+    p.failed = 0;
+
+    i32 arg = 1;
+    while (arg + 1 < argc && argv[arg][0] == '-') {
+        u32 value = (u32)std::strtoul(argv[arg + 1], nullptr, 10);
+        if (std::strcmp(argv[arg], "-j") == 0 && value > 0) {
+            p.threads = value;
+        } else if (std::strcmp(argv[arg], "-b") == 0 && value > 0 && value <= 1024 * 1024) {
+            // keep blocks a multiple of the alignment
+            p.block_size = (value * 1024 + BLOCK_ALIGN - 1) / BLOCK_ALIGN * BLOCK_ALIGN;
+        } else {
+            usage();
+            return 1;
+        }
+        arg += 2;
+    }
+    if (argc - arg != 3) {
+        usage();
+        return 1;
+    }
+
+    const char* mode = argv[arg];
+    if      (std::strcmp(mode, "upper") == 0) p.mode = MODE_UPPER;
+    else if (std::strcmp(mode, "lower") == 0) p.mode = MODE_LOWER;
+    else if (std::strcmp(mode, "fold")  == 0) p.mode = MODE_FOLD;
+    else if (std::strcmp(mode, "count") == 0) p.mode = MODE_COUNT;
+    else {
+        usage();
+        return 1;
+    }
+
+    p.in = std::fopen(argv[arg + 1], "rb");
+    if (p.in == nullptr) {
+        std::fprintf(stderr, "Error: Could not open file for reading: %s\n", argv[arg + 1]);
+        return 1;
+    }
+    if (p.mode == MODE_COUNT) {
+        p.pattern = (u8*)argv[arg + 2];
+        p.pattern_len = string_length(p.pattern);
+        if (p.pattern_len == 0 || p.pattern_len > p.block_size) {
+            std::fprintf(stderr, "Error: pattern must be 1 to %u bytes.\n", p.block_size);
+            std::fclose(p.in);
+            return 1;
+        }
+    } else {
+        p.out = std::fopen(argv[arg + 2], "wb");
+        if (p.out == nullptr) {
+            std::fprintf(stderr, "Error: Could not open file for writing: %s\n", argv[arg + 2]);
+            std::fclose(p.in);
+            return 1;
+        }
+    }
+
+    // the fixed pool: enough blocks to keep every stage busy, never more
+    u32 pool_size = p.threads * 2 + 2;
+    u32 overlap = p.pattern_len > 0 ? p.pattern_len - 1 : 0;
+    u32 block_bytes = (p.block_size + overlap + BLOCK_ALIGN - 1) / BLOCK_ALIGN * BLOCK_ALIGN;
+    std::vector<Block> blocks(pool_size);
+    BlockQueue free_blocks, work, done;
+    for (u32 i = 0; i < pool_size; i++) {
+        blocks[i].data = (u8*)::operator new(block_bytes, std::align_val_t(BLOCK_ALIGN));
+        free_blocks.push(&blocks[i]);
+    }
+
+    std::thread reader(read_stage, &p, &free_blocks, &work);
+    std::vector<std::thread> workers;
+    for (u32 i = 0; i < p.threads; i++) {
+        workers.emplace_back(work_stage, &p, &work, &done);
+    }
+    u64 matches = 0;
+    std::thread writer([&] { matches = write_stage(&p, &done, &free_blocks, pool_size); });
+
+    reader.join();
+    for (std::thread& worker : workers) worker.join();
+    done.close();
+    writer.join();
+
+    for (u32 i = 0; i < pool_size; i++) {
+        ::operator delete(blocks[i].data, std::align_val_t(BLOCK_ALIGN));
+    }
+    std::fclose(p.in);
+    if (p.out != nullptr && std::fclose(p.out) != 0) p.failed = 1;
+
+    if (p.failed) {
+        std::fprintf(stderr, "Error: I/O failed.\n");
+        return 1;
+    }
+    if (p.mode == MODE_COUNT) {
+        printf("%llu\n", matches);
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+// Benchmarks for string_lib kernels against libc.
+// build: g++ -O2 -std=c++17 string_bench.cpp string_lib.cpp string_search.cpp string_number.cpp string_hash.cpp string_utf8.cpp string_token.cpp -o string_bench
+
+#include "string_lib.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <charconv>
+
+// seconds since the previous call
+static double lap() {
+    static auto last = std::chrono::steady_clock::now();
+    auto now = std::chrono::steady_clock::now();
+    double s = std::chrono::duration<double>(now - last).count();
+    last = now;
+    return s;
+}
+
+// keeps results alive so the compiler can't drop the timed loops
+static volatile u64 sink;
+
+static void report(const char* what, double seconds, double bytes) {
+    printf("  %-28s %8.3f ms  %8.2f GB/s\n", what, seconds * 1e3, bytes / seconds / 1e9);
+}
+
+// string_length against the plain byte loop it replaced and libc, short strings
+// (call overhead) and one long string (throughput)
+static void bench_length() {
+    const u32 short_lens[] = { 0, 3, 7, 15, 16, 31, 64 };
+    const u32 calls = 50000000;
+    const u32 copies = 16;              // same length at 16 different alignments
+    u8 pool[copies][96];
+    char* volatile strs[copies];        // volatile so strlen isn't folded or hoisted
+
+    printf("length of short strings, %u calls each (ns per call)\n", calls);
+    printf("  %-6s %12s %12s %12s\n", "bytes", "byte loop", "string_length", "libc strlen");
+    for (u32 len : short_lens) {
+        for (u32 c = 0; c < copies; c++) {
+            u8* s = pool[c] + c;
+            for (u32 i = 0; i < len; i++) s[i] = (u8)('a' + i % 26);
+            s[len] = '\0';
+            strs[c] = (char*)s;
+        }
+
+        lap();
+        for (u32 i = 0; i < calls; i++) sink += string_length_scalar((u8*)strs[i % copies]);
+        double loop = lap();
+        for (u32 i = 0; i < calls; i++) sink += string_length((u8*)strs[i % copies]);
+        double ours = lap();
+        for (u32 i = 0; i < calls; i++) sink += std::strlen(strs[i % copies]);
+        double libc = lap();
+        printf("  %-6u %12.2f %12.2f %12.2f\n", len, loop * 1e9 / calls, ours * 1e9 / calls, libc * 1e9 / calls);
+    }
+
+    const u32 len  = 1 << 20;
+    const u32 reps = 1000;
+    u8* big = (u8*)std::malloc(len + 1);
+    for (u32 i = 0; i < len; i++) big[i] = (u8)('a' + i % 26);
+    big[len] = '\0';
+    char* volatile big_str = (char*)big;
+    double bytes = (double)len * reps;
+
+    printf("length of %u bytes x %u\n", len, reps);
+
+    lap();
+    for (u32 r = 0; r < reps; r++) sink += string_length_scalar((u8*)big_str);
+    report("byte loop", lap(), bytes);
+    for (u32 r = 0; r < reps; r++) sink += string_length((u8*)big_str);
+    report("string_length", lap(), bytes);
+    for (u32 r = 0; r < reps; r++) sink += std::strlen(big_str);
+    report("libc strlen", lap(), bytes);
+
+    std::free(big);
+}
+
+// two equal long strings, compared to the end
+static void bench_compare() {
+    const u32 len  = 1 << 20;
+    const u32 reps = 200;
+    u8* a = (u8*)std::malloc(len + 1);
+    u8* b = (u8*)std::malloc(len + 1);
+    for (u32 i = 0; i < len; i++) a[i] = b[i] = (u8)('a' + i % 26);
+    a[len] = b[len] = '\0';
+    double bytes = (double)len * reps;
+
+    printf("compare %u equal bytes x %u\n", len, reps);
+
+    lap();
+    for (u32 r = 0; r < reps; r++) sink += (u64)std::strcmp((char*)a, (char*)b);
+    report("libc strcmp", lap(), bytes);
+    for (u32 r = 0; r < reps; r++) sink += (u64)str_compare(a, b);
+    report("str_compare", lap(), bytes);
+    for (u32 r = 0; r < reps; r++) sink += (u64)str_mismatch_scalar(a, b);
+    report("str_mismatch_scalar", lap(), bytes);
+    for (u32 r = 0; r < reps; r++) sink += (u64)std::memcmp(a, b, len);
+    report("libc memcmp", lap(), bytes);
+    for (u32 r = 0; r < reps; r++) sink += (u64)mem_compare(a, len, b, len);
+    report("mem_compare", lap(), bytes);
+
+    std::free(a);
+    std::free(b);
+}
+
+// sort many short keys sharing long prefixes
+static void bench_sort() {
+    const u32 count = 1000000;
+    const u32 key_len = 24;
+    std::vector<u8> pool((size_t)count * (key_len + 1));
+    std::vector<u8*> keys(count);
+    std::srand(1);
+    for (u32 k = 0; k < count; k++) {
+        u8* s = &pool[(size_t)k * (key_len + 1)];
+        for (u32 i = 0; i < key_len; i++) s[i] = (u8)(i < 12 ? 'k' : 'a' + std::rand() % 26);
+        s[key_len] = '\0';
+        keys[k] = s;
+    }
+    std::vector<u8*> copy = keys;
+
+    printf("sort %u keys of %u bytes\n", count, key_len);
+
+    lap();
+    std::sort(copy.begin(), copy.end(), [](u8* x, u8* y) { return std::strcmp((char*)x, (char*)y) < 0; });
+    printf("  %-28s %8.3f ms\n", "std::sort + strcmp", lap() * 1e3);
+
+    copy = keys;
+    lap();
+    std::sort(copy.begin(), copy.end(), str_less);
+    printf("  %-28s %8.3f ms\n", "std::sort + str_less", lap() * 1e3);
+}
+
+// format and parse many u32 values
+static void bench_numbers() {
+    const u32 count = 10000000;
+    std::vector<u32> values(count);
+    std::srand(2);
+    for (u32 i = 0; i < count; i++) values[i] = (u32)std::rand() * 2654435761u >> (i % 32);
+    char buf[32];
+    u8 out[32];
+
+    printf("format %u u32 values, width 10\n", count);
+
+    lap();
+    for (u32 i = 0; i < count; i++) sink += (u64)std::snprintf(buf, sizeof(buf), "%*u", 10, values[i]);
+    printf("  %-28s %8.3f ms\n", "snprintf %*u", lap() * 1e3);
+    for (u32 i = 0; i < count; i++) sink += (u64)(std::to_chars(buf, buf + sizeof(buf), values[i]).ptr - buf);
+    printf("  %-28s %8.3f ms\n", "std::to_chars (no padding)", lap() * 1e3);
+    for (u32 i = 0; i < count; i++) sink += format_u32(values[i], out, 10);
+    printf("  %-28s %8.3f ms\n", "format_u32", lap() * 1e3);
+
+    // the same values as text, back to back
+    std::vector<u8> text;
+    std::vector<u32> offsets(count + 1);
+    for (u32 i = 0; i < count; i++) {
+        offsets[i] = (u32)text.size();
+        u32 n = format_u32(values[i], out, 0);
+        text.insert(text.end(), out, out + n);
+        text.push_back('\0');
+    }
+    offsets[count] = (u32)text.size();
+
+    printf("parse %u u32 values\n", count);
+
+    lap();
+    for (u32 i = 0; i < count; i++) sink += std::strtoul((char*)&text[offsets[i]], nullptr, 10);
+    printf("  %-28s %8.3f ms\n", "strtoul", lap() * 1e3);
+    for (u32 i = 0; i < count; i++) {
+        u32 v = 0;
+        const char* first = (const char*)&text[offsets[i]];
+        std::from_chars(first, first + (offsets[i + 1] - offsets[i] - 1), v);
+        sink += v;
+    }
+    printf("  %-28s %8.3f ms\n", "std::from_chars", lap() * 1e3);
+    for (u32 i = 0; i < count; i++) {
+        u32 v = 0;
+        parse_u32(&text[offsets[i]], offsets[i + 1] - offsets[i] - 1, &v);
+        sink += v;
+    }
+    printf("  %-28s %8.3f ms\n", "parse_u32", lap() * 1e3);
+}
+
+int main() {
+    printf("string kernels: %s\n", string_kernels()->name);
+    bench_length();
+    bench_compare();
+    bench_sort();
+    bench_numbers();
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include "string_lib.h"
+#include "string_simd.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// --- hashing ---
+// wyhash: 64x64->128 multiply-and-fold mixing, 48 bytes per round on long keys
+// and at most two overlapping loads for keys up to 16 bytes.
+
+static const u64 hash_secret[4] = {
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+// full 128-bit product of a and b, low half in a, high half in b
+static inline void mul_128(u64* a, u64* b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (u64)r;
+    *b = (u64)(r >> 64);
+#else
+    u64 ha = *a >> 32, hb = *b >> 32, la = (u32)*a, lb = (u32)*b;
+    u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    u64 t = rl + (rm0 << 32);
+    u64 carry = t < rl;
+    u64 lo = t + (rm1 << 32);
+    carry += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+static inline u64 mix(u64 a, u64 b) {
+    mul_128(&a, &b);
+    return a ^ b;
+}
+
+static inline u64 load_le64(const u8* p) {
+    u64 v = load_u64(p);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline u64 load_le32(const u8* p) {
+    return (u64)p[0] | ((u64)p[1] << 8) | ((u64)p[2] << 16) | ((u64)p[3] << 24);
+}
+
+u64 str_hash(u8 data[], u32 len, u64 seed) {
+    const u8* p = data;
+    const u64* s = hash_secret;
+    u64 a, b;
+
+    seed ^= mix(seed ^ s[0], s[1]);
+    if (len <= 16) {
+        if (len >= 4) {
+            u32 mid = (len >> 3) << 2;
+            a = (load_le32(p) << 32) | load_le32(p + mid);
+            b = (load_le32(p + len - 4) << 32) | load_le32(p + len - 4 - mid);
+        } else if (len > 0) {
+            a = ((u64)p[0] << 16) | ((u64)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        u32 i = len;
+        if (i > 48) {
+            u64 see1 = seed, see2 = seed;
+            do {
+                seed = mix(load_le64(p) ^ s[1], load_le64(p + 8) ^ seed);
+                see1 = mix(load_le64(p + 16) ^ s[2], load_le64(p + 24) ^ see1);
+                see2 = mix(load_le64(p + 32) ^ s[3], load_le64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = mix(load_le64(p) ^ s[1], load_le64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = load_le64(p + i - 16);
+        b = load_le64(p + i - 8);
+    }
+
+    a ^= s[1];
+    b ^= seed;
+    mul_128(&a, &b);
+    return mix(a ^ s[0] ^ len, b ^ s[1]);
+}
+
+// --- interning ---
+
+#define INTERN_MIN_SLOTS   64
+#define INTERN_ARENA_BLOCK (64 * 1024)
+
+// slot layout: high 32 bits = hash tag, low 32 bits = id + 1 (0 = empty)
+static inline u64 make_slot(u64 hash, u32 id) {
+    return (hash & 0xFFFFFFFF00000000ULL) | ((u64)id + 1);
+}
+
+StrInternTable::StrInternTable() : mask(0), arena_used(0), arena_size(0), arena_total(0) {
+    slots.assign(INTERN_MIN_SLOTS, 0);
+    mask = INTERN_MIN_SLOTS - 1;
+}
+
+StrInternTable::~StrInternTable() {
+    for (u8* block : arena_blocks) free(block);
+}
+
+// copy a key into the arena (NUL terminated), nullptr if out of memory
+u8* StrInternTable::store(u8 str[], u32 len) {
+    u64 need = (u64)len + 1;
+    if (arena_blocks.empty() || arena_used + need > arena_size) {
+        u64 size = need > INTERN_ARENA_BLOCK ? need : INTERN_ARENA_BLOCK;
+        u8* block = (u8*)malloc((size_t)size);
+        if (block == nullptr) return nullptr;
+        arena_blocks.push_back(block);
+        arena_used = 0;
+        arena_size = size;
+        arena_total += size;
+    }
+    u8* copy = arena_blocks.back() + arena_used;
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    arena_used += need;
+    return copy;
+}
+
+// double the slot array and reinsert every id from its stored hash
+void StrInternTable::grow() {
+    u64 new_size = slots.size() * 2;
+    std::vector<u64> bigger(new_size, 0);
+    u64 new_mask = new_size - 1;
+    for (u32 id = 0; id < views.size(); id++) {
+        u64 i = hashes[id] & new_mask;
+        while (bigger[i] != 0) i = (i + 1) & new_mask;
+        bigger[i] = make_slot(hashes[id], id);
+    }
+    slots.swap(bigger);
+    mask = new_mask;
+}
+
+u32 StrInternTable::find(u8 str[], u32 len) const {
+    u64 hash = str_hash(str, len, 0);
+    u64 tag = hash & 0xFFFFFFFF00000000ULL;
+    for (u64 i = hash & mask;; i = (i + 1) & mask) {
+        u64 slot = slots[i];
+        if (slot == 0) return INTERN_NONE;
+        if ((slot & 0xFFFFFFFF00000000ULL) == tag) {
+            u32 id = (u32)slot - 1;
+            if (views[id].len == len && memcmp(views[id].data, str, len) == 0) return id;
+        }
+    }
+}
+
+u32 StrInternTable::intern(u8 str[], u32 len) {
+    u64 hash = str_hash(str, len, 0);
+    u64 tag = hash & 0xFFFFFFFF00000000ULL;
+    u64 i = hash & mask;
+    for (;; i = (i + 1) & mask) {
+        u64 slot = slots[i];
+        if (slot == 0) break;
+        if ((slot & 0xFFFFFFFF00000000ULL) == tag) {
+            u32 id = (u32)slot - 1;
+            if (views[id].len == len && memcmp(views[id].data, str, len) == 0) return id;
+        }
+    }
+
+    // new key
+    if (views.size() >= INTERN_NONE - 1) return INTERN_NONE;
+    u8* copy = store(str, len);
+    if (copy == nullptr) return INTERN_NONE;
+
+    u32 id = (u32)views.size();
+    StrView view = { copy, len };
+    views.push_back(view);
+    hashes.push_back(hash);
+
+    // keep the load factor at or below 3/4
+    if ((u64)views.size() * 4 > slots.size() * 3) {
+        grow();
+        return id;
+    }
+    slots[i] = make_slot(hash, id);
+    return id;
+}
+
+StrView StrInternTable::lookup(u32 id) const {
+    if (id >= views.size()) {
+        StrView none = { nullptr, 0 };
+        return none;
+    }
+    return views[id];
+}
+
+InternStats StrInternTable::stats() const {
+    InternStats st;
+    st.count = (u32)views.size();
+    st.slots = (u64)slots.size();
+    st.load_factor = (double)st.count / (double)st.slots;
+    st.max_probe = 0;
+    st.arena_bytes = arena_total;
+    for (u32 k = 0; k < INTERN_PROBE_BUCKETS; k++) st.probe_histogram[k] = 0;
+
+    // probe length of a key = distance from its home slot to where it sits
+    u64 total = 0;
+    for (u64 i = 0; i < slots.size(); i++) {
+        if (slots[i] == 0) continue;
+        u32 id = (u32)slots[i] - 1;
+        u32 probe = (u32)((i - (hashes[id] & mask)) & mask);
+        total += probe;
+        if (probe > st.max_probe) st.max_probe = probe;
+        st.probe_histogram[probe < INTERN_PROBE_BUCKETS - 1 ? probe : INTERN_PROBE_BUCKETS - 1]++;
+    }
+    st.mean_probe = st.count > 0 ? (double)total / st.count : 0.0;
+    return st;
+}
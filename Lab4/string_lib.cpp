@@ -1,7 +1,12 @@
 #include "string_lib.h"
+#include "string_simd.h"
 
-// calculate the length of a string
-u32 string_length(u8 str []){
+#include <stdlib.h>
+#include <string.h>
+
+// --- string_length kernels ---
+
+u32 string_length_scalar(u8 str[]) {
     u32 length = 0;
     while (str[length] != '\0') {
         length++;
@@ -9,48 +14,462 @@ u32 string_length(u8 str []){
     return length;
 }
 
-// compare two strings  
-u32 str_cmp(u8 str1[], u8 str2[]){
-    //return 0 if equal, 1 if str1 > str2, -1 if str1 < str2
-    // work on the length & ASCII values of characters
-    u32 i = 0;
-    while (str1[i] != '\0' && str2[i] != '\0') {
-        if (str1[i] < str2[i]) {            //compare character by character
-            return -1;
-        } else if (str1[i] > str2[i]) {     //compare character by character
-            return 1;
+u32 string_length_swar(u8 str[]) {
+    const u8* p = str;
+
+    // byte by byte until p is 8-byte aligned, aligned loads can't cross a page
+    while (((uintptr_t)p & 7) != 0) {
+        if (*p == '\0') return (u32)(p - str);
+        p++;
+    }
+
+    for (;;) {
+        u64 v = load_u64(p);
+        if (swar_has_zero(v)) {
+            return (u32)(p - str) + swar_first_byte(swar_zero_bytes(v));
         }
+        p += 8;
+    }
+}
+
+// --- case conversion kernels ---
+// dst may be the same buffer as src. upper != 0 maps 'a'-'z' up, else 'A'-'Z' down.
+
+void case_convert_scalar(u8 dst[], u8 src[], u32 len, bool_t upper) {
+    u8 first = upper ? 'a' : 'A';
+    u8 delta = upper ? (u8)-('a' - 'A') : (u8)('a' - 'A');
+    for (u32 i = 0; i < len; i++) {
+        u8 c = src[i];
+        u8 in_range = (u8)(c - first) < 26;     // one unsigned compare, no branch
+        dst[i] = (u8)(c + (delta & (u8)-in_range));
+    }
+}
+
+void case_convert_swar(u8 dst[], u8 src[], u32 len, bool_t upper) {
+    u8 first = upper ? 'a' : 'A';
+    u32 i = 0;
+    for (; i + 8 <= len; i += 8) {
+        u64 v = swar_case(load_u64(src + i), first, upper);
+        memcpy(dst + i, &v, sizeof(v));
+    }
+    case_convert_scalar(dst + i, src + i, len - i, upper);
+}
+
+// --- mismatch kernels ---
+
+// non-zero if an unaligned load of n bytes at p could run into the next page
+static inline bool_t near_page_end(const u8* p, u32 n) {
+    return ((uintptr_t)p & 4095) > 4096 - n;
+}
+
+// bytes left before either pointer reaches the end of its page
+static inline u32 bytes_to_page_end(const u8* a, const u8* b) {
+    u32 room_a = 4096 - (u32)((uintptr_t)a & 4095);
+    u32 room_b = 4096 - (u32)((uintptr_t)b & 4095);
+    return room_a < room_b ? room_a : room_b;
+}
+
+u32 str_mismatch_scalar(u8 str1[], u8 str2[]) {
+    u32 i = 0;
+    while (str1[i] == str2[i] && str1[i] != '\0') {
         i++;
     }
-    if (str1[i] == '\0' && str2[i] == '\0') {   //strings are equal
-        return 0;                                
-    } else if (str1[i] == '\0') {                   //str2 is longer
-        return -5;
-    } else {                                        //str1 is longer
-        return 5;
+    return i;
+}
+
+u32 mem_mismatch_scalar(u8 a[], u8 b[], u32 len) {
+    u32 i = 0;
+    while (i < len && a[i] == b[i]) {
+        i++;
     }
+    return i;
 }
 
-// transform lowercase to uppercase
-void to_uppercase(u8 str[]){
+u32 str_mismatch_swar(u8 str1[], u8 str2[]) {
     u32 i = 0;
-    while (str[i] != '\0') {
-        if (str[i] >= 'a' && str[i] <= 'z') {
-            str[i] = str[i] - ('a' - 'A');
+    for (;;) {
+        if (near_page_end(str1 + i, 8) || near_page_end(str2 + i, 8)) {
+            // the next 8 bytes may not all exist, go byte by byte up to the terminator
+            for (u32 k = 0; k < 8; k++, i++) {
+                if (str1[i] != str2[i] || str1[i] == '\0') return i;
+            }
+            continue;
         }
-        i++;
+        u64 a = load_u64(str1 + i);
+        u64 b = load_u64(str2 + i);
+        u64 stop = swar_nonzero_bytes(a ^ b) | swar_zero_bytes(a);
+        if (stop) return i + swar_first_byte(stop);
+        i += 8;
     }
 }
 
-// transform uppercase to lowercase
-void to_lowercase(u8 str[]){
+u32 mem_mismatch_swar(u8 a[], u8 b[], u32 len) {
     u32 i = 0;
-    while (str[i] != '\0') {
-        if (str[i] >= 'A' && str[i] <= 'Z') {
-            str[i] = str[i] + ('a' - 'A');
+    for (; i + 8 <= len; i += 8) {
+        u64 x = load_u64(a + i) ^ load_u64(b + i);
+        if (x) return i + swar_first_byte(swar_nonzero_bytes(x));
+    }
+    return i + mem_mismatch_scalar(a + i, b + i, len - i);
+}
+
+#if STRING_LIB_X86
+
+TARGET_SSE2
+u32 string_length_sse2(u8 str[]) {
+    const __m128i zero = _mm_setzero_si128();
+
+    // first aligned block, ignore the bytes before str
+    const u8* p = (const u8*)((uintptr_t)str & ~(uintptr_t)15);
+    u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)p), zero));
+    mask >>= (u32)(str - p);
+    if (mask) return lowest_bit(mask);
+
+    for (;;) {
+        p += 16;
+        mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i*)p), zero));
+        if (mask) return (u32)(p - str) + lowest_bit(mask);
+    }
+}
+
+TARGET_AVX2
+u32 string_length_avx2(u8 str[]) {
+    const __m256i zero = _mm256_setzero_si256();
+
+    // first aligned block, ignore the bytes before str
+    const u8* p = (const u8*)((uintptr_t)str & ~(uintptr_t)31);
+    u32 mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i*)p), zero));
+    mask >>= (u32)(str - p);
+    if (mask) return lowest_bit(mask);
+    p += 32;
+
+    // one more block if needed so the main loop starts 64-byte aligned
+    if (((uintptr_t)p & 63) != 0) {
+        mask = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i*)p), zero));
+        if (mask) return (u32)(p - str) + lowest_bit(mask);
+        p += 32;
+    }
+
+    // 64 bytes per iteration, min of both halves is 0 only if one of them has a 0
+    for (;;) {
+        __m256i a = _mm256_load_si256((const __m256i*)p);
+        __m256i b = _mm256_load_si256((const __m256i*)(p + 32));
+        __m256i m = _mm256_min_epu8(a, b);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(m, zero))) {
+            u32 lo = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, zero));
+            u32 hi = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, zero));
+            u64 both = ((u64)hi << 32) | lo;
+            return (u32)(p - str) + lowest_bit(both);
         }
-        i++;
+        p += 64;
+    }
+}
+
+// range compare: bytes in [first, first + 26) are moved into [-128, -102) as signed,
+// so one signed compare gives the mask, and the masked 0x20 is added or subtracted
+TARGET_SSE2
+void case_convert_sse2(u8 dst[], u8 src[], u32 len, bool_t upper) {
+    u8 first = upper ? 'a' : 'A';
+    const __m128i shift = _mm_set1_epi8((char)(0x80 - first));
+    const __m128i limit = _mm_set1_epi8((char)(-128 + 26));
+    const __m128i flip  = _mm_set1_epi8(0x20);
+
+    u32 i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v    = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i mask = _mm_cmplt_epi8(_mm_add_epi8(v, shift), limit);
+        __m128i d    = _mm_and_si128(mask, flip);
+        v = upper ? _mm_sub_epi8(v, d) : _mm_add_epi8(v, d);
+        _mm_storeu_si128((__m128i*)(dst + i), v);
+    }
+    case_convert_swar(dst + i, src + i, len - i, upper);
+}
+
+TARGET_AVX2
+void case_convert_avx2(u8 dst[], u8 src[], u32 len, bool_t upper) {
+    u8 first = upper ? 'a' : 'A';
+    const __m256i shift = _mm256_set1_epi8((char)(0x80 - first));
+    const __m256i limit = _mm256_set1_epi8((char)(-128 + 26));
+    const __m256i flip  = _mm256_set1_epi8(0x20);
+
+    u32 i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v    = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i mask = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(v, shift));
+        __m256i d    = _mm256_and_si256(mask, flip);
+        v = upper ? _mm256_sub_epi8(v, d) : _mm256_add_epi8(v, d);
+        _mm256_storeu_si256((__m256i*)(dst + i), v);
+    }
+    case_convert_sse2(dst + i, src + i, len - i, upper);
+}
+
+// movemask of "equal and not the terminator", the first 0 bit is where to stop
+TARGET_SSE2
+u32 str_mismatch_sse2(u8 str1[], u8 str2[]) {
+    const __m128i zero = _mm_setzero_si128();
+    u32 i = 0;
+    for (;;) {
+        // full vectors until the nearer of the two page ends, bytes across it
+        u32 room = bytes_to_page_end(str1 + i, str2 + i);
+        for (; room >= 16; room -= 16, i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(str1 + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(str2 + i));
+            u32 same = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+            u32 end  = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(a, zero));
+            u32 stop = ~(same & ~end) & 0xFFFF;
+            if (stop) return i + lowest_bit(stop);
+        }
+        for (u32 k = 0; k < 16; k++, i++) {
+            if (str1[i] != str2[i] || str1[i] == '\0') return i;
+        }
+    }
+}
+
+TARGET_SSE2
+u32 mem_mismatch_sse2(u8 a[], u8 b[], u32 len) {
+    u32 i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        u32 diff = ~(u32)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) & 0xFFFF;
+        if (diff) return i + lowest_bit(diff);
+    }
+    return i + mem_mismatch_swar(a + i, b + i, len - i);
+}
+
+TARGET_AVX2
+u32 str_mismatch_avx2(u8 str1[], u8 str2[]) {
+    const __m256i zero = _mm256_setzero_si256();
+    u32 i = 0;
+    for (;;) {
+        // full vectors until the nearer of the two page ends, bytes across it
+        u32 room = bytes_to_page_end(str1 + i, str2 + i);
+        for (; room >= 32; room -= 32, i += 32) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(str1 + i));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(str2 + i));
+            u32 same = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+            u32 end  = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, zero));
+            u32 stop = ~(same & ~end);
+            if (stop) return i + lowest_bit(stop);
+        }
+        for (u32 k = 0; k < 32; k++, i++) {
+            if (str1[i] != str2[i] || str1[i] == '\0') return i;
+        }
+    }
+}
+
+TARGET_AVX2
+u32 mem_mismatch_avx2(u8 a[], u8 b[], u32 len) {
+    u32 i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        u32 diff = ~(u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb));
+        if (diff) return i + lowest_bit(diff);
+    }
+    return i + mem_mismatch_sse2(a + i, b + i, len - i);
+}
+
+#else
+
+// no x86 vectors on this target, the portable kernels are the best we have
+u32 string_length_sse2(u8 str[]) { return string_length_swar(str); }
+u32 string_length_avx2(u8 str[]) { return string_length_swar(str); }
+void case_convert_sse2(u8 dst[], u8 src[], u32 len, bool_t upper) { case_convert_swar(dst, src, len, upper); }
+void case_convert_avx2(u8 dst[], u8 src[], u32 len, bool_t upper) { case_convert_swar(dst, src, len, upper); }
+u32 str_mismatch_sse2(u8 str1[], u8 str2[]) { return str_mismatch_swar(str1, str2); }
+u32 str_mismatch_avx2(u8 str1[], u8 str2[]) { return str_mismatch_swar(str1, str2); }
+u32 mem_mismatch_sse2(u8 a[], u8 b[], u32 len) { return mem_mismatch_swar(a, b, len); }
+u32 mem_mismatch_avx2(u8 a[], u8 b[], u32 len) { return mem_mismatch_swar(a, b, len); }
+
+#endif
+
+// --- runtime CPU dispatch ---
+
+static const StringKernels kernel_sets[] = {
+    {
+        "avx2",
+        string_length_avx2,
+        case_convert_avx2,
+        str_mismatch_avx2,
+        mem_mismatch_avx2,
+        str_find_all_avx2,
+        utf8_validate_avx2,
+        utf8_case_convert_avx2,
+        byte_set_bitmap_avx2,
+    },
+    {
+        "sse2",
+        string_length_sse2,
+        case_convert_sse2,
+        str_mismatch_sse2,
+        mem_mismatch_sse2,
+        str_find_all_sse2,
+        utf8_validate_sse2,
+        utf8_case_convert_sse2,
+        byte_set_bitmap_sse2,
+    },
+    {
+        "swar",
+        string_length_swar,
+        case_convert_swar,
+        str_mismatch_swar,
+        mem_mismatch_swar,
+        str_find_all_swar,
+        utf8_validate_swar,
+        utf8_case_convert_swar,
+        byte_set_bitmap_swar,
+    },
+    {
+        "scalar",
+        string_length_scalar,
+        case_convert_scalar,
+        str_mismatch_scalar,
+        mem_mismatch_scalar,
+        str_find_all_scalar,
+        utf8_validate_scalar,
+        utf8_case_convert_scalar,
+        byte_set_bitmap_scalar,
+    },
+};
+
+#define KERNEL_SET_COUNT (sizeof(kernel_sets) / sizeof(kernel_sets[0]))
+
+// can this CPU run the kernel set at index i
+static bool_t kernel_set_supported(u32 i) {
+#if STRING_LIB_X86
+    if (strcmp(kernel_sets[i].name, "avx2") == 0) return __builtin_cpu_supports("avx2");
+    if (strcmp(kernel_sets[i].name, "sse2") == 0) return __builtin_cpu_supports("sse2");
+#else
+    if (strcmp(kernel_sets[i].name, "avx2") == 0) return 0;
+    if (strcmp(kernel_sets[i].name, "sse2") == 0) return 0;
+#endif
+    return 1;
+}
+
+// best supported set, sets are ordered fastest first
+static const StringKernels* detect_string_kernels() {
+#if STRING_LIB_X86
+    // this runs from a static initializer, possibly before libgcc has filled in the
+    // CPU model data that __builtin_cpu_supports reads
+    __builtin_cpu_init();
+#endif
+    for (u32 i = 0; i < KERNEL_SET_COUNT; i++) {
+        if (kernel_set_supported(i)) return &kernel_sets[i];
+    }
+    return &kernel_sets[KERNEL_SET_COUNT - 1];
+}
+
+// The active set, plus its string_length on its own so the hottest call is a single
+// load. Both start as the portable fallbacks (constant initialisation, so calls from
+// other files' static constructors are safe) and are upgraded while the program starts.
+static const StringKernels* active = &kernel_sets[KERNEL_SET_COUNT - 1];
+static u32 (*active_string_length)(u8 str[]) = string_length_scalar;
+
+static bool_t install_kernels(const StringKernels* set) {
+    active = set;
+    active_string_length = set->string_length;
+    return 1;
+}
+
+// pick the kernels while the program starts instead of on the first call
+static bool_t startup_kernels = install_kernels(detect_string_kernels());
+
+const StringKernels* string_kernels() {
+    return active;
+}
+
+bool_t select_string_kernels(const char* name) {
+    for (u32 i = 0; i < KERNEL_SET_COUNT; i++) {
+        if (strcmp(kernel_sets[i].name, name) == 0 && kernel_set_supported(i)) {
+            return install_kernels(&kernel_sets[i]);
+        }
+    }
+    return 0;
+}
+
+// calculate the length of a string
+// The first STRING_LENGTH_INLINE bytes are checked right here with two u64 loads, so
+// short strings never pay for the indirect call or a kernel's alignment prologue. The
+// loads may only read past the terminator within the same page, like the kernels do.
+u32 string_length(u8 str []){
+    if (str[0] == '\0') return 0;              // empty strings: as cheap as the byte loop
+    if (((uintptr_t)str & 4095) <= 4096 - STRING_LENGTH_INLINE) {
+        u64 lo = load_u64(str);
+        if (swar_has_zero(lo)) return swar_first_byte(swar_zero_bytes(lo));
+        u64 hi = load_u64(str + 8);
+        if (swar_has_zero(hi)) return 8 + swar_first_byte(swar_zero_bytes(hi));
+        return STRING_LENGTH_INLINE + active_string_length(str + STRING_LENGTH_INLINE);
+    }
+    return active_string_length(str);
+}
+
+// compare two strings  
+i32 str_cmp(u8 str1[], u8 str2[]){
+    //return 0 if equal, 1 if str1 > str2, -1 if str1 < str2
+    // -5 / 5 when one string is a prefix of the other (shorter one is smaller)
+    u32 i = active->str_mismatch(str1, str2);
+    if (str1[i] == str2[i]) {                   //strings are equal
+        return 0;
+    } else if (str1[i] == '\0') {               //str2 is longer
+        return -5;
+    } else if (str2[i] == '\0') {               //str1 is longer
+        return 5;
     }
+    return str1[i] < str2[i] ? -1 : 1;          //first differing character decides
+}
+
+// index of the first byte where the strings differ
+u32 str_mismatch(u8 str1[], u8 str2[]){
+    return active->str_mismatch(str1, str2);
+}
+
+// index of the first differing byte in the first len bytes
+u32 mem_mismatch(u8 a[], u8 b[], u32 len){
+    return active->mem_mismatch(a, b, len);
+}
+
+// signed ordering like strcmp: < 0, 0 or > 0
+i32 str_compare(u8 str1[], u8 str2[]){
+    u32 i = active->str_mismatch(str1, str2);
+    return (i32)str1[i] - (i32)str2[i];
+}
+
+// signed ordering of two sized buffers, a shorter prefix sorts first
+i32 mem_compare(u8 a[], u32 len_a, u8 b[], u32 len_b){
+    u32 n = len_a < len_b ? len_a : len_b;
+    u32 i = active->mem_mismatch(a, b, n);
+    if (i < n) return (i32)a[i] - (i32)b[i];
+    return len_a < len_b ? -1 : (len_a > len_b ? 1 : 0);
+}
+
+// strict weak ordering for std::sort
+bool str_less(u8* str1, u8* str2){
+    return str_compare(str1, str2) < 0;
+}
+
+// transform lowercase to uppercase
+void to_uppercase(u8 str[]){
+    to_uppercase_n(str, string_length(str));
+}
+
+// transform uppercase to lowercase
+void to_lowercase(u8 str[]){
+    to_lowercase_n(str, string_length(str));
+}
+
+// transform the first len bytes to uppercase
+void to_uppercase_n(u8 str[], u32 len){
+    active->case_convert(str, str, len, 1);
+}
+
+// transform the first len bytes to lowercase
+void to_lowercase_n(u8 str[], u32 len){
+    active->case_convert(str, str, len, 0);
+}
+
+// write the lowercase form of src into dst in one pass
+void case_fold_copy(u8 dst[], u8 src[], u32 len){
+    active->case_convert(dst, src, len, 0);
 }
 
 // concatenate two strings
@@ -71,10 +490,112 @@ void str_concat(u8 str1[], u8 str2[], u32 size_str1){
 
 //copy a string
 void str_copy(u8 str1[], u8 str2[], u32 size_str1){
+    if (size_str1 == 0) {
+        return; // no room even for the terminator
+    }
     u32 i = 0;
     while (str2[i] != '\0' && i < size_str1 - 1) {
         str1[i] = str2[i];
         i++;
     }
     str1[i] = '\0'; // null terminate str1
-} 
\ No newline at end of file
+}
+
+// --- sized strings ---
+
+StrView str_view(u8 str[]){
+    StrView v = { str, string_length(str) };
+    return v;
+}
+
+// shared terminator so an empty builder still has a valid c_str()
+static u8 empty_string[1] = { '\0' };
+
+StrBuilder::StrBuilder() : data(nullptr), len(0), cap(0) {}
+
+StrBuilder::StrBuilder(u32 capacity) : data(nullptr), len(0), cap(0) {
+    reserve(capacity);
+}
+
+StrBuilder::~StrBuilder() {
+    free(data);
+}
+
+StrBuilder::StrBuilder(StrBuilder&& other) noexcept : data(other.data), len(other.len), cap(other.cap) {
+    other.data = nullptr;
+    other.len = 0;
+    other.cap = 0;
+}
+
+StrBuilder& StrBuilder::operator=(StrBuilder&& other) noexcept {
+    if (this != &other) {
+        free(data);
+        data = other.data;
+        len = other.len;
+        cap = other.cap;
+        other.data = nullptr;
+        other.len = 0;
+        other.cap = 0;
+    }
+    return *this;
+}
+
+bool_t StrBuilder::reserve(u32 capacity) {
+    if (capacity <= cap && data != nullptr) return 1;
+    if (capacity == 0xFFFFFFFFu) return 0;          // no room left for the terminator
+
+    u8* grown = (u8*)realloc(data, (size_t)capacity + 1);
+    if (grown == nullptr) return 0;
+    if (data == nullptr) grown[0] = '\0';
+    data = grown;
+    cap = capacity;
+    return 1;
+}
+
+bool_t StrBuilder::append(u8 str[], u32 n) {
+    if (n > 0xFFFFFFFEu - len) return 0;            // would not fit in a u32 length
+    u32 needed = len + n;
+    if (needed > cap || data == nullptr) {
+        // geometric growth keeps a chain of appends linear overall
+        u64 grown = (u64)cap * 2;
+        if (grown < 16) grown = 16;
+        if (grown < needed) grown = needed;
+        if (grown > 0xFFFFFFFEu) grown = 0xFFFFFFFEu;
+
+        // str may point into our own buffer, which realloc can move
+        bool_t inside = data != nullptr && str >= data && str <= data + len;
+        u32 offset = inside ? (u32)(str - data) : 0;
+        if (!reserve((u32)grown)) return 0;
+        if (inside) str = data + offset;
+    }
+    memcpy(data + len, str, n);
+    len = needed;
+    data[len] = '\0';
+    return 1;
+}
+
+bool_t StrBuilder::append(u8 str[]) {
+    return append(str, string_length(str));
+}
+
+bool_t StrBuilder::append(StrView view) {
+    return append(view.data, view.len);
+}
+
+bool_t StrBuilder::append_char(u8 c) {
+    return append(&c, 1);
+}
+
+void StrBuilder::clear() {
+    len = 0;
+    if (data != nullptr) data[0] = '\0';
+}
+
+u8* StrBuilder::c_str() {
+    return data != nullptr ? data : empty_string;
+}
+
+StrView StrBuilder::view() {
+    StrView v = { c_str(), len };
+    return v;
+}
@@ -3,11 +3,14 @@
 #ifndef STRING_LIB_H
 #define STRING_LIB_H
 
+#include <string.h>
+#include <vector>
+
 // calculate the length of a string
 u32 string_length(u8 str []);
 
-// compare two strings  
-u32 str_cmp(u8 str1[], u8 str2[]);
+// compare two strings: 0 equal, -1 / 1 first differing character, -5 / 5 one is a prefix
+i32 str_cmp(u8 str1[], u8 str2[]);
 
 // transform lowercase to uppercase
 void to_uppercase(u8 str[]);
@@ -19,11 +22,496 @@ void to_lowercase(u8 str[]);
 void str_concat(u8 str1[], u8 str2[], u32 size_str1);
 
 //copy a string
-void str_copy(u8 str1[], u8 str2[], u32 size_str1); 
+void str_copy(u8 str1[], u8 str2[], u32 size_str1);
+
+// transform the first len bytes to uppercase (no terminator needed)
+void to_uppercase_n(u8 str[], u32 len);
+
+// transform the first len bytes to lowercase (no terminator needed)
+void to_lowercase_n(u8 str[], u32 len);
+
+// write the lowercase (case folded) form of src[0..len) into dst, dst may be src
+void case_fold_copy(u8 dst[], u8 src[], u32 len);
+
+// index of the first byte where the strings differ (index of the terminator if equal)
+u32 str_mismatch(u8 str1[], u8 str2[]);
+
+// index of the first differing byte in a[0..len) and b[0..len), len if equal
+u32 mem_mismatch(u8 a[], u8 b[], u32 len);
+
+// signed ordering like strcmp (unsigned bytes): < 0, 0 or > 0
+i32 str_compare(u8 str1[], u8 str2[]);
+
+// signed ordering of two sized buffers, a shorter prefix sorts first
+i32 mem_compare(u8 a[], u32 len_a, u8 b[], u32 len_b);
+
+// strict weak ordering for std::sort over u8* keys
+bool str_less(u8* str1, u8* str2);
+
+// --- UTF-8 ---
+
+// non-zero if str[0..len) is well-formed UTF-8 (no overlongs, surrogates or values above U+10FFFF)
+bool_t utf8_validate(u8 str[], u32 len);
+
+// case-map UTF-8 text: ASCII letters plus the Latin-1, Latin Extended-A, Greek and Cyrillic
+// letters whose other case has the same encoded length, so dst may be src. Malformed
+// bytes are copied unchanged.
+void utf8_to_upper(u8 dst[], u8 src[], u32 len);
+void utf8_to_lower(u8 dst[], u8 src[], u32 len);
+
+// --- numbers ---
+// No allocation, no exceptions, no locale: results come back through an error code.
+
+typedef enum {
+    PARSE_OK = 0,
+    PARSE_EMPTY,        // no digits
+    PARSE_INVALID,      // a byte that is not a digit (or a sign where i64 allows one)
+    PARSE_OVERFLOW      // too big for the result type
+} ParseStatus;
+
+// parse all of str[0..len) as decimal digits, *out is only written on PARSE_OK
+ParseStatus parse_u32(u8 str[], u32 len, u32* out);
+
+// same with an optional leading '+' or '-'
+ParseStatus parse_i64(u8 str[], u32 len, i64* out);
+
+// write value right-aligned in width characters (space padded, like "%*u") and a
+// terminator, returns the characters written. out needs max(width, 10 or 20) + 1 bytes.
+u32 format_u32(u32 value, u8 out[], u32 width);
+u32 format_u64(u64 value, u8 out[], u32 width);
+
+// --- search ---
+
+// called once per match with the match offset and the pattern id (0 for single
+// pattern search). Return 0 to stop the scan. user is passed through untouched.
+typedef bool_t (*MatchCallback)(u32 offset, u32 pattern_id, void* user);
+
+// offset of the first needle in hay, hay_len if there is none
+u32 str_find(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len);
+
+// report every (overlapping) needle in hay, returns the number of matches reported.
+// on_match may be nullptr to just count. An empty needle never matches.
+u32 str_find_all(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len, MatchCallback on_match, void* user);
+
+// --- byte sets ---
+
+#define BYTE_SET_MAX_VECTOR 16              // larger sets skip the vector kernels
+
+// a set of byte values: the members listed for the compare kernels and a
+// 256-bit membership map for single byte tests
+typedef struct {
+    u8  bytes[BYTE_SET_MAX_VECTOR];         // the first BYTE_SET_MAX_VECTOR members
+    u32 count;                              // distinct members
+    u64 member[4];
+} ByteSet;
+
+void byte_set_init(ByteSet* set, const u8 bytes[], u32 count);
+
+inline bool_t byte_set_has(const ByteSet* set, u8 c) {
+    return (bool_t)((set->member[c >> 6] >> (c & 63)) & 1);
+}
+
+// --- string_length kernels ---
+// All of them only use aligned loads, so they never read across a page boundary.
+u32 string_length_scalar(u8 str[]);     // one byte per iteration
+u32 string_length_swar(u8 str[]);       // 8 bytes per iteration in a u64 (portable)
+u32 string_length_sse2(u8 str[]);       // 16 bytes per iteration (x86 only)
+u32 string_length_avx2(u8 str[]);       // 32 bytes per iteration (x86 only)
+
+// string_length checks this many leading bytes itself (two u64 loads) before calling a kernel
+#define STRING_LENGTH_INLINE 16
+
+// --- case conversion kernels ---
+// Branchless range compare + masked add. upper != 0 maps 'a'-'z' up, else 'A'-'Z' down.
+void case_convert_scalar(u8 dst[], u8 src[], u32 len, bool_t upper);
+void case_convert_swar(u8 dst[], u8 src[], u32 len, bool_t upper);
+void case_convert_sse2(u8 dst[], u8 src[], u32 len, bool_t upper);
+void case_convert_avx2(u8 dst[], u8 src[], u32 len, bool_t upper);
+
+// --- mismatch kernels ---
+// Vector compare + movemask to find the first differing byte. The NUL-terminated
+// ones drop to bytes near a page end so they never read past the terminator's page.
+u32 str_mismatch_scalar(u8 str1[], u8 str2[]);
+u32 str_mismatch_swar(u8 str1[], u8 str2[]);
+u32 str_mismatch_sse2(u8 str1[], u8 str2[]);
+u32 str_mismatch_avx2(u8 str1[], u8 str2[]);
+u32 mem_mismatch_scalar(u8 a[], u8 b[], u32 len);
+u32 mem_mismatch_swar(u8 a[], u8 b[], u32 len);
+u32 mem_mismatch_sse2(u8 a[], u8 b[], u32 len);
+u32 mem_mismatch_avx2(u8 a[], u8 b[], u32 len);
+
+// --- search kernels ---
+// Compare 8/16/32 positions at once against the needle's first and last byte,
+// and check the middle only where both match.
+u32 str_find_all_scalar(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len, MatchCallback on_match, void* user);
+u32 str_find_all_swar(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len, MatchCallback on_match, void* user);
+u32 str_find_all_sse2(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len, MatchCallback on_match, void* user);
+u32 str_find_all_avx2(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len, MatchCallback on_match, void* user);
+
+// --- UTF-8 kernels ---
+// Pure-ASCII blocks take the ASCII path (8/16/32 bytes at a time), anything else is
+// handled one sequence at a time. The AVX2 validator is the Keiser-Lemire nibble lookup.
+bool_t utf8_validate_scalar(u8 str[], u32 len);
+bool_t utf8_validate_swar(u8 str[], u32 len);
+bool_t utf8_validate_sse2(u8 str[], u32 len);
+bool_t utf8_validate_avx2(u8 str[], u32 len);
+void utf8_case_convert_scalar(u8 dst[], u8 src[], u32 len, bool_t upper);
+void utf8_case_convert_swar(u8 dst[], u8 src[], u32 len, bool_t upper);
+void utf8_case_convert_sse2(u8 dst[], u8 src[], u32 len, bool_t upper);
+void utf8_case_convert_avx2(u8 dst[], u8 src[], u32 len, bool_t upper);
+
+// --- byte set kernels ---
+// Bit i of bits[i / 64] is set when data[i] is in the set; every word up to
+// (len + 63) / 64 is written, bits past len are 0. One compare per member per vector.
+void byte_set_bitmap_scalar(u8 data[], u32 len, const ByteSet* set, u64 bits[]);
+void byte_set_bitmap_swar(u8 data[], u32 len, const ByteSet* set, u64 bits[]);
+void byte_set_bitmap_sse2(u8 data[], u32 len, const ByteSet* set, u64 bits[]);
+void byte_set_bitmap_avx2(u8 data[], u32 len, const ByteSet* set, u64 bits[]);
+
+// --- runtime CPU dispatch ---
+// Filled once at startup with the fastest kernels the CPU supports.
+typedef struct {
+    const char* name;                   // "avx2", "sse2", "swar" or "scalar"
+    u32 (*string_length)(u8 str[]);
+    void (*case_convert)(u8 dst[], u8 src[], u32 len, bool_t upper);
+    u32 (*str_mismatch)(u8 str1[], u8 str2[]);
+    u32 (*mem_mismatch)(u8 a[], u8 b[], u32 len);
+    u32 (*str_find_all)(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len, MatchCallback on_match, void* user);
+    bool_t (*utf8_validate)(u8 str[], u32 len);
+    void (*utf8_case_convert)(u8 dst[], u8 src[], u32 len, bool_t upper);
+    void (*byte_set_bitmap)(u8 data[], u32 len, const ByteSet* set, u64 bits[]);
+} StringKernels;
+
+// the kernels picked for this CPU
+const StringKernels* string_kernels();
+
+// force a kernel set by name ("avx2", "sse2", "swar", "scalar"), returns 0 if unsupported here
+bool_t select_string_kernels(const char* name);
+
+// --- sized strings ---
+
+// non-owning view of len bytes at data, works with the u8[] functions above
+typedef struct {
+    u8* data;
+    u32 len;
+} StrView;
+
+// view of a NUL-terminated string
+StrView str_view(u8 str[]);
+
+// growable, length-carrying string. Appends are amortized O(1) (capacity doubles),
+// the buffer is always NUL terminated and owned by exactly one builder (move-only).
+class StrBuilder {
+public:
+    StrBuilder();
+    explicit StrBuilder(u32 capacity);
+    ~StrBuilder();
+
+    StrBuilder(StrBuilder&& other) noexcept;
+    StrBuilder& operator=(StrBuilder&& other) noexcept;
+    StrBuilder(const StrBuilder&) = delete;
+    StrBuilder& operator=(const StrBuilder&) = delete;
+
+    // make room for capacity bytes (plus the terminator), returns 0 if allocation failed
+    bool_t reserve(u32 capacity);
+
+    // append bytes, each returns 0 (and leaves the string unchanged) if allocation failed
+    bool_t append(u8 str[]);
+    bool_t append(u8 str[], u32 len);
+    bool_t append(StrView view);
+    bool_t append_char(u8 c);
+
+    // drop the contents, keep the buffer
+    void clear();
+
+    u32 length() const { return len; }
+    u32 capacity() const { return cap; }
 
+    // NUL-terminated contents, valid until the next append
+    u8* c_str();
+    StrView view();
 
+private:
+    u8* data;
+    u32 len;
+    u32 cap;                            // bytes usable for text, the buffer holds cap + 1
+};
 
+// --- hashing and interning ---
 
+// 64-bit hash of data[0..len) (wyhash construction), fast on short keys
+u64 str_hash(u8 data[], u32 len, u64 seed);
 
+#define INTERN_NONE          0xFFFFFFFFu    // "no id" from find() / failed intern()
+#define INTERN_PROBE_BUCKETS 9              // histogram: probe lengths 0..7, then 8 or more
+
+// sizing numbers for a StrInternTable
+typedef struct {
+    u32    count;                           // distinct strings stored
+    u64    slots;                           // size of the slot array
+    double load_factor;                     // count / slots (kept <= 0.75)
+    double mean_probe;                      // average extra slots visited to find a stored key
+    u32    max_probe;
+    u32    probe_histogram[INTERN_PROBE_BUCKETS];
+    u64    arena_bytes;                     // memory held for the key bytes
+} InternStats;
+
+// Deduplicates strings into stable 32-bit ids (0, 1, 2, ... in first-seen order).
+// Open addressing with linear probing; each slot packs 32 bits of the hash with the
+// id, so most mismatches are rejected without touching the key. Keys are copied once
+// into an arena and stay put, so the views returned by lookup() never move.
+class StrInternTable {
+public:
+    StrInternTable();
+    ~StrInternTable();
+    StrInternTable(const StrInternTable&) = delete;
+    StrInternTable& operator=(const StrInternTable&) = delete;
+
+    // id of the string, adding it if new (INTERN_NONE only if out of memory or ids)
+    u32 intern(u8 str[], u32 len);
+
+    // id of the string if already stored, else INTERN_NONE
+    u32 find(u8 str[], u32 len) const;
+
+    // the stored bytes of an id (NUL terminated), {nullptr, 0} for an unknown id
+    StrView lookup(u32 id) const;
+
+    u32 size() const { return (u32)views.size(); }
+    InternStats stats() const;
+
+private:
+    u8*  store(u8 str[], u32 len);
+    void grow();
+
+    std::vector<u64>     slots;             // hash tag << 32 | (id + 1), 0 = empty
+    u64                  mask;              // slots.size() - 1
+    std::vector<StrView> views;             // by id
+    std::vector<u64>     hashes;            // by id, so growing never rehashes keys
+
+    std::vector<u8*>     arena_blocks;
+    u64                  arena_used;        // bytes used in the last block
+    u64                  arena_size;        // size of the last block
+    u64                  arena_total;
+};
+
+// --- multi-pattern search ---
+
+// Aho-Corasick automaton for matching many keywords in one pass over the text.
+// build() turns the trie into a full DFA stored as one flat u32 table: one row per
+// state, one column per byte class (bytes no pattern uses share a single column).
+class AhoCorasick {
+public:
+    AhoCorasick();
+
+    // add a keyword, returns its pattern id (ids count up from 0). Call build() afterwards.
+    u32 add_pattern(u8 pattern[], u32 len);
+
+    // compile the added patterns into the transition table
+    void build();
+
+    // report every match in text (offset = start of the match), returns the number reported
+    u32 scan(u8 text[], u32 len, MatchCallback on_match, void* user) const;
+
+    u32 pattern_count() const { return (u32)pattern_len.size(); }
+    u32 state_count() const;
+
+private:
+    static const u32 OUTPUT_FLAG = 0x80000000u;     // set in entries leading to a state with matches
+
+    u8  byte_class[256];
+    u32 class_count;
+    bool_t built;
+
+    std::vector<u8>  pattern_bytes;                 // all patterns back to back
+    std::vector<u32> pattern_start;
+    std::vector<u32> pattern_len;
+
+    std::vector<u32> transitions;                   // row offset of the next state | OUTPUT_FLAG
+    std::vector<u32> output_start;                  // per state, into output_ids
+    std::vector<u32> output_count;
+    std::vector<u32> output_ids;
+};
+
+// --- tokenizing ---
+
+// a field of a tokenized buffer: data[offset .. offset + len)
+typedef struct {
+    u32 offset;
+    u32 len;
+} Span;
+
+#define TOKEN_WINDOW 4096                   // bytes classified per kernel call
+
+// Splits a buffer on any of a set of delimiter bytes without copying or writing to it;
+// fields come back as spans into the original buffer. The byte set kernel marks every
+// delimiter (and quote) in a TOKEN_WINDOW-byte window at once, and the fields are then
+// read off that bitmap with one count-trailing-zeros per field.
+//
+// Splitting follows the usual split() rules: n delimiters give n + 1 fields, so empty
+// fields (and a trailing empty field after a final delimiter) are reported unless
+// skip_empty is set. With a quote byte, a field that starts with it runs to the matching
+// closing quote, delimiters inside are kept, the span excludes the quotes, and doubled
+// quotes inside stay doubled (unescaping would need a copy). A quote byte anywhere else
+// is an ordinary byte.
+class Tokenizer {
+public:
+    Tokenizer(u8 text[], u32 text_len, const char* delimiters, u8 quote_char = 0, bool_t skip_empty_fields = 0);
+
+    // the next field, 0 when there are none left
+    bool_t next(Span* out);
+
+    // up to max fields into out, returns how many (0 when done)
+    u32 next_batch(Span out[], u32 max);
+
+private:
+    u32 next_special(u32 p);
+    u32 next_delimiter(u32 p);
+
+    u8*     data;
+    u32     len;
+    u8      quote;
+    bool_t  skip_empty;
+    ByteSet delims;
+    ByteSet specials;                       // delimiters and the quote
+    void  (*kernel)(u8 data[], u32 len, const ByteSet* set, u64 bits[]);
+
+    u64 bits[TOKEN_WINDOW / 64];            // special bytes in data[window_start ..)
+    u32 window_start;
+    u32 window_len;
+    u32 pos;                                // start of the next field
+    bool_t done;
+};
+
+// --- fixed-size buffers ---
+// Versions that take the array itself, so the bound comes from the type instead of a
+// separate size argument. They are constexpr: lengths of literals fold at compile time,
+// buffers up to FIXED_UNROLL_LIMIT bytes are processed in fully unrolled branchless
+// loops. At run time bigger buffers are scanned and copied with libc memchr/memcpy,
+// which stop at N (the string_length kernels would run on past an unterminated
+// buffer), and case conversion uses the library's _n kernels.
+// (Plain overloads of the u8[] names would never be picked: for a u8 array the
+// non-template pointer version wins the tie, hence the _fixed suffix.)
+
+#define FIXED_UNROLL_LIMIT 32
+
+#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+#define STR_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#define STR_CONSTANT_EVALUATED() true       // no way to tell, always take the constexpr path
+#endif
+
+// length of the string in str, N if there is no terminator
+template <u32 N>
+constexpr u32 string_length_fixed(const u8 (&str)[N]) {
+    if (N > FIXED_UNROLL_LIMIT && !STR_CONSTANT_EVALUATED()) {
+        const void* end = memchr(str, '\0', N);
+        return end != nullptr ? (u32)((const u8*)end - str) : N;
+    }
+    u32 length = 0;
+    while (length < N && str[length] != '\0') {
+        length++;
+    }
+    return length;
+}
+
+// length of a string literal, a compile time constant
+template <u32 N>
+constexpr u32 string_length_fixed(const char (&str)[N]) {
+    u32 length = 0;
+    while (length < N && str[length] != '\0') {
+        length++;
+    }
+    return length;
+}
+
+// copy src into dst, truncating to fit. When src is no bigger than dst the capacity
+// check disappears: the type already proves it fits.
+template <u32 N, u32 M>
+constexpr void str_copy_fixed(u8 (&dst)[N], const u8 (&src)[M]) {
+    constexpr u32 limit = (M < N - 1) ? M : N - 1;
+
+    if (limit > FIXED_UNROLL_LIMIT && !STR_CONSTANT_EVALUATED()) {
+        u32 len = string_length_fixed(src);
+        if (len > limit) len = limit;
+        memcpy(dst, src, len);
+        dst[len] = '\0';
+        return;
+    }
+
+    // constant trip count, no early exit: bytes after the terminator become 0
+    bool_t alive = 1;
+    for (u32 i = 0; i < limit; i++) {
+        alive = alive && src[i] != '\0';
+        dst[i] = alive ? src[i] : (u8)'\0';
+    }
+    dst[limit] = '\0';
+}
+
+// copy a string literal into dst, truncating to fit
+template <u32 N, u32 M>
+constexpr void str_copy_fixed(u8 (&dst)[N], const char (&src)[M]) {
+    constexpr u32 limit = (M < N - 1) ? M : N - 1;
+    bool_t alive = 1;
+    for (u32 i = 0; i < limit; i++) {
+        alive = alive && src[i] != '\0';
+        dst[i] = alive ? (u8)src[i] : (u8)'\0';
+    }
+    dst[limit] = '\0';
+}
+
+// append src to the string in dst, returns 0 (dst unchanged) if it does not fit
+template <u32 N, u32 M>
+constexpr bool_t str_concat_fixed(u8 (&dst)[N], const u8 (&src)[M]) {
+    u32 len1 = string_length_fixed(dst);
+    if (len1 >= N) {
+        return 0; // dst is not terminated
+    }
+    u32 len2 = string_length_fixed(src);
+    if (M > N - len1 - 1 && len2 > N - len1 - 1) {
+        return 0; // not enough space to concatenate
+    }
+    if (len2 > FIXED_UNROLL_LIMIT && !STR_CONSTANT_EVALUATED()) {
+        memcpy(dst + len1, src, len2);
+    } else {
+        for (u32 i = 0; i < len2; i++) {
+            dst[len1 + i] = src[i];
+        }
+    }
+    dst[len1 + len2] = '\0';
+    return 1;
+}
+
+// convert the string in str (up to its terminator) with a branchless per-byte step
+template <u32 N>
+constexpr void case_convert_fixed(u8 (&str)[N], bool_t upper) {
+    if (N > FIXED_UNROLL_LIMIT && !STR_CONSTANT_EVALUATED()) {
+        u32 len = string_length_fixed(str);
+        if (upper) to_uppercase_n(str, len);
+        else       to_lowercase_n(str, len);
+        return;
+    }
+
+    u8 first = upper ? 'a' : 'A';
+    u8 delta = upper ? (u8)-('a' - 'A') : (u8)('a' - 'A');
+    bool_t alive = 1;
+    for (u32 i = 0; i < N; i++) {
+        u8 c = str[i];
+        alive = alive && c != '\0';
+        bool_t convert = alive && (u8)(c - first) < 26;
+        str[i] = (u8)(c + (convert ? delta : 0));
+    }
+}
+
+// transform lowercase to uppercase
+template <u32 N>
+constexpr void to_uppercase_fixed(u8 (&str)[N]) {
+    case_convert_fixed(str, 1);
+}
+
+// transform uppercase to lowercase
+template <u32 N>
+constexpr void to_lowercase_fixed(u8 (&str)[N]) {
+    case_convert_fixed(str, 0);
+}
 
-#endif // STRING_LIB_H
\ No newline at end of file
+#endif // STRING_LIB_H
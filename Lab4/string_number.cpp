@@ -0,0 +1,168 @@
+#include "string_lib.h"
+#include "string_simd.h"
+
+// --- parsing ---
+
+// every one of the 8 bytes is '0'..'9'
+static inline bool_t swar_is_8_digits(u64 v) {
+    return (((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+            == 0x3333333333333333ULL);
+}
+
+// value of 8 digit characters, first character in the lowest byte:
+// pairs of digits, then groups of 4, then all 8 in three multiplies
+static inline u32 swar_parse_8_digits(u64 v) {
+    v = (v & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+    v = (v & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+    return (u32)((v & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32);
+}
+
+// same for 4 digit characters
+static inline bool_t swar_is_4_digits(u32 v) {
+    return (((v & 0xF0F0F0F0u) | (((v + 0x06060606u) & 0xF0F0F0F0u) >> 4)) == 0x33333333u);
+}
+
+static inline u32 swar_parse_4_digits(u32 v) {
+    v = (v & 0x0F0F0F0Fu) * 2561 >> 8;
+    return (v & 0x00FF00FFu) * 6553601 >> 16;
+}
+
+static inline u32 load_digits_4(const u8* p) {
+    u32 v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+// first digit character in the lowest byte whatever the byte order
+static inline u64 load_digits(const u8* p) {
+    u64 v = load_u64(p);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+// value of str[0..len), all digits and at most max_digits of them after leading zeros
+static ParseStatus parse_digits(const u8* str, u32 len, u32 max_digits, u64* out) {
+    if (len == 0) return PARSE_EMPTY;
+
+    u32 i = 0;
+    while (i < len && str[i] == '0') i++;
+    bool_t too_long = len - i > max_digits;
+
+    u64 value = 0;
+    for (; i + 8 <= len; i += 8) {
+        u64 chunk = load_digits(str + i);
+        if (!swar_is_8_digits(chunk)) return PARSE_INVALID;
+        value = value * 100000000 + swar_parse_8_digits(chunk);
+    }
+    if (i + 4 <= len) {
+        u32 chunk = load_digits_4(str + i);
+        if (!swar_is_4_digits(chunk)) return PARSE_INVALID;
+        value = value * 10000 + swar_parse_4_digits(chunk);
+        i += 4;
+    }
+    for (; i < len; i++) {
+        u32 digit = (u32)str[i] - '0';
+        if (digit > 9) return PARSE_INVALID;
+        value = value * 10 + digit;
+    }
+
+    if (too_long) return PARSE_OVERFLOW;
+    *out = value;
+    return PARSE_OK;
+}
+
+ParseStatus parse_u32(u8 str[], u32 len, u32* out) {
+    u64 value = 0;
+    ParseStatus status = parse_digits(str, len, 10, &value);
+    if (status != PARSE_OK) return status;
+    if (value > 0xFFFFFFFFULL) return PARSE_OVERFLOW;
+    *out = (u32)value;
+    return PARSE_OK;
+}
+
+ParseStatus parse_i64(u8 str[], u32 len, i64* out) {
+    bool_t negative = 0;
+    if (len > 0 && (str[0] == '-' || str[0] == '+')) {
+        negative = str[0] == '-';
+        str++;
+        len--;
+    }
+
+    u64 value = 0;
+    ParseStatus status = parse_digits(str, len, 19, &value);
+    if (status != PARSE_OK) return status;
+
+    const u64 limit = 0x7FFFFFFFFFFFFFFFULL;
+    if (value > limit + (negative ? 1 : 0)) return PARSE_OVERFLOW;
+    *out = negative ? (i64)(0 - value) : (i64)value;
+    return PARSE_OK;
+}
+
+// --- formatting ---
+
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const u64 powers_of_10[20] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+// number of decimal digits in value (at least 1): bits * log10(2), then one compare
+static inline u32 count_digits(u64 value) {
+    value |= 1;                         // 0 still has one digit
+    u32 guess = ((highest_bit(value) + 1) * 1233) >> 12;
+    return guess + (value >= powers_of_10[guess]);
+}
+
+// write value right-aligned in a field of width characters, space padded.
+// A template so the u32 version divides in 32-bit registers.
+template <typename T>
+static u32 format_digits(T value, u8 out[], u32 width) {
+    u32 digits = count_digits(value);
+    u32 pad = width > digits ? width - digits : 0;
+    for (u32 k = 0; k < pad; k++) out[k] = ' ';
+
+    // two digits per step from the end
+    u8* p = out + pad + digits;
+    *p = '\0';
+    while (value >= 100) {
+        u32 pair = (u32)(value % 100) * 2;
+        value /= 100;
+        p -= 2;
+        p[0] = (u8)digit_pairs[pair];
+        p[1] = (u8)digit_pairs[pair + 1];
+    }
+    if (value >= 10) {
+        p -= 2;
+        p[0] = (u8)digit_pairs[value * 2];
+        p[1] = (u8)digit_pairs[value * 2 + 1];
+    } else {
+        *--p = (u8)('0' + value);
+    }
+    return pad + digits;
+}
+
+u32 format_u32(u32 value, u8 out[], u32 width) {
+    return format_digits<u32>(value, out, width);
+}
+
+u32 format_u64(u64 value, u8 out[], u32 width) {
+    return format_digits<u64>(value, out, width);
+}
@@ -0,0 +1,303 @@
+#include "string_lib.h"
+#include "string_simd.h"
+
+#include <string.h>
+#include <vector>
+
+// --- single pattern search kernels ---
+// Filter candidate positions on the first and last byte of the needle, then
+// compare the middle only where both match ("generic SIMD strstr").
+
+// report a match, returns 0 if the callback asked to stop
+static inline bool_t report_match(u32 offset, MatchCallback on_match, void* user) {
+    return on_match == nullptr || on_match(offset, 0, user);
+}
+
+// does the needle match at hay + i, given that first and last byte already do
+static inline bool_t middle_matches(const u8* hay, u32 i, u8 needle[], u32 needle_len) {
+    if (needle_len <= 2) return 1;
+    return mem_mismatch((u8*)hay + i + 1, needle + 1, needle_len - 2) == needle_len - 2;
+}
+
+u32 str_find_all_scalar(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len,
+                        MatchCallback on_match, void* user) {
+    if (needle_len == 0 || needle_len > hay_len) return 0;
+    u8 first = needle[0];
+    u8 last = needle[needle_len - 1];
+    u32 count = 0;
+    for (u32 i = 0; i + needle_len <= hay_len; i++) {
+        if (hay[i] == first && hay[i + needle_len - 1] == last && middle_matches(hay, i, needle, needle_len)) {
+            count++;
+            if (!report_match(i, on_match, user)) return count;
+        }
+    }
+    return count;
+}
+
+u32 str_find_all_swar(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len,
+                      MatchCallback on_match, void* user) {
+    if (needle_len == 0 || needle_len > hay_len) return 0;
+    u64 first = SWAR_ONES * needle[0];
+    u64 last = SWAR_ONES * needle[needle_len - 1];
+    u32 count = 0;
+    u32 i = 0;
+
+    // 8 candidate positions per step: a byte of (f | l) is 0 where both ends match
+    for (; i + needle_len - 1 + 8 <= hay_len; i += 8) {
+        u64 f = load_u64(hay + i) ^ first;
+        u64 l = load_u64(hay + i + needle_len - 1) ^ last;
+        u64 mask = swar_zero_bytes(f | l);
+        while (mask) {
+            u32 k = swar_first_byte(mask);
+            if (middle_matches(hay, i + k, needle, needle_len)) {
+                count++;
+                if (!report_match(i + k, on_match, user)) return count;
+            }
+            mask = swar_clear_first_byte(mask);
+        }
+    }
+
+    // the last few positions one by one
+    for (; i + needle_len <= hay_len; i++) {
+        if (hay[i] == needle[0] && hay[i + needle_len - 1] == needle[needle_len - 1] &&
+            middle_matches(hay, i, needle, needle_len)) {
+            count++;
+            if (!report_match(i, on_match, user)) return count;
+        }
+    }
+    return count;
+}
+
+#if STRING_LIB_X86
+
+TARGET_SSE2
+u32 str_find_all_sse2(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len,
+                      MatchCallback on_match, void* user) {
+    if (needle_len == 0 || needle_len > hay_len) return 0;
+    const __m128i first = _mm_set1_epi8((char)needle[0]);
+    const __m128i last = _mm_set1_epi8((char)needle[needle_len - 1]);
+    u32 count = 0;
+    u32 i = 0;
+
+    for (; i + needle_len - 1 + 16 <= hay_len; i += 16) {
+        __m128i f = _mm_loadu_si128((const __m128i*)(hay + i));
+        __m128i l = _mm_loadu_si128((const __m128i*)(hay + i + needle_len - 1));
+        u32 mask = (u32)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(f, first), _mm_cmpeq_epi8(l, last)));
+        while (mask) {
+            u32 k = lowest_bit(mask);
+            if (middle_matches(hay, i + k, needle, needle_len)) {
+                count++;
+                if (!report_match(i + k, on_match, user)) return count;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    for (; i + needle_len <= hay_len; i++) {
+        if (hay[i] == needle[0] && hay[i + needle_len - 1] == needle[needle_len - 1] &&
+            middle_matches(hay, i, needle, needle_len)) {
+            count++;
+            if (!report_match(i, on_match, user)) return count;
+        }
+    }
+    return count;
+}
+
+TARGET_AVX2
+u32 str_find_all_avx2(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len,
+                      MatchCallback on_match, void* user) {
+    if (needle_len == 0 || needle_len > hay_len) return 0;
+    const __m256i first = _mm256_set1_epi8((char)needle[0]);
+    const __m256i last = _mm256_set1_epi8((char)needle[needle_len - 1]);
+    u32 count = 0;
+    u32 i = 0;
+
+    for (; i + needle_len - 1 + 32 <= hay_len; i += 32) {
+        __m256i f = _mm256_loadu_si256((const __m256i*)(hay + i));
+        __m256i l = _mm256_loadu_si256((const __m256i*)(hay + i + needle_len - 1));
+        u32 mask = (u32)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(f, first), _mm256_cmpeq_epi8(l, last)));
+        while (mask) {
+            u32 k = lowest_bit(mask);
+            if (middle_matches(hay, i + k, needle, needle_len)) {
+                count++;
+                if (!report_match(i + k, on_match, user)) return count;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    for (; i + needle_len <= hay_len; i++) {
+        if (hay[i] == needle[0] && hay[i + needle_len - 1] == needle[needle_len - 1] &&
+            middle_matches(hay, i, needle, needle_len)) {
+            count++;
+            if (!report_match(i, on_match, user)) return count;
+        }
+    }
+    return count;
+}
+
+#else
+
+u32 str_find_all_sse2(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len, MatchCallback on_match, void* user) {
+    return str_find_all_swar(hay, hay_len, needle, needle_len, on_match, user);
+}
+u32 str_find_all_avx2(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len, MatchCallback on_match, void* user) {
+    return str_find_all_swar(hay, hay_len, needle, needle_len, on_match, user);
+}
+
+#endif
+
+// --- single pattern search ---
+
+u32 str_find_all(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len, MatchCallback on_match, void* user) {
+    return string_kernels()->str_find_all(hay, hay_len, needle, needle_len, on_match, user);
+}
+
+// stores the first offset and stops the scan
+static bool_t keep_first(u32 offset, u32 pattern_id, void* user) {
+    (void)pattern_id;
+    *(u32*)user = offset;
+    return 0;
+}
+
+u32 str_find(u8 hay[], u32 hay_len, u8 needle[], u32 needle_len) {
+    if (needle_len == 0) return 0;
+    u32 offset = hay_len;
+    string_kernels()->str_find_all(hay, hay_len, needle, needle_len, keep_first, &offset);
+    return offset;
+}
+
+// --- Aho-Corasick ---
+
+AhoCorasick::AhoCorasick() : class_count(1), built(0) {
+    for (u32 c = 0; c < 256; c++) byte_class[c] = 0;
+}
+
+u32 AhoCorasick::add_pattern(u8 pattern[], u32 len) {
+    u32 id = (u32)pattern_start.size();
+    pattern_start.push_back((u32)pattern_bytes.size());
+    pattern_len.push_back(len);
+    pattern_bytes.insert(pattern_bytes.end(), pattern, pattern + len);
+    built = 0;
+    return id;
+}
+
+void AhoCorasick::build() {
+    // byte classes: every byte used by a pattern gets its own column, all others share column 0
+    for (u32 c = 0; c < 256; c++) byte_class[c] = 0;
+    class_count = 1;
+    for (u8 c : pattern_bytes) {
+        if (byte_class[c] == 0) byte_class[c] = (u8)class_count++;
+        if (class_count == 256) break;
+    }
+    if (class_count == 256) {
+        // every byte value is used, identity mapping with one column per byte
+        for (u32 c = 0; c < 256; c++) byte_class[c] = (u8)c;
+        class_count = 256;
+    }
+
+    // trie, one dense row of class_count entries per state, 0 = no edge (root is never a child)
+    std::vector<u32> trie(class_count, 0);
+    std::vector<std::vector<u32>> own(1);           // patterns ending exactly at each state
+    for (u32 id = 0; id < pattern_len.size(); id++) {
+        if (pattern_len[id] == 0) continue;         // the empty pattern never reports
+        u32 state = 0;
+        for (u32 k = 0; k < pattern_len[id]; k++) {
+            u32 cls = byte_class[pattern_bytes[pattern_start[id] + k]];
+            u32 next_state = trie[state * class_count + cls];
+            if (next_state == 0) {
+                next_state = (u32)own.size();
+                own.emplace_back();
+                trie.resize(trie.size() + class_count, 0);
+                trie[state * class_count + cls] = next_state;
+            }
+            state = next_state;
+        }
+        own[state].push_back(id);
+    }
+    u32 state_total = (u32)own.size();
+
+    // breadth-first: failure links, complete transitions (a DFA) and merged output lists
+    std::vector<u32> fail(state_total, 0);
+    std::vector<u32> order;
+    order.reserve(state_total);
+    for (u32 cls = 0; cls < class_count; cls++) {
+        u32 child = trie[cls];
+        if (child != 0) order.push_back(child);
+    }
+    for (u32 head = 0; head < order.size(); head++) {
+        u32 state = order[head];
+        for (u32 cls = 0; cls < class_count; cls++) {
+            u32& edge = trie[state * class_count + cls];
+            u32 fallback = trie[fail[state] * class_count + cls];
+            if (edge != 0) {
+                fail[edge] = fallback;
+                order.push_back(edge);
+            } else {
+                edge = fallback;
+            }
+        }
+    }
+
+    // outputs in one flat array: own patterns first, then those of the failure state,
+    // which is shallower and so already done in breadth-first order
+    output_start.assign(state_total, 0);
+    output_count.assign(state_total, 0);
+    output_ids.clear();
+    order.insert(order.begin(), 0);
+    for (u32 state : order) {
+        output_start[state] = (u32)output_ids.size();
+        output_ids.insert(output_ids.end(), own[state].begin(), own[state].end());
+        if (state != 0) {
+            u32 f = fail[state];
+            for (u32 k = 0; k < output_count[f]; k++) output_ids.push_back(output_ids[output_start[f] + k]);
+        }
+        output_count[state] = (u32)output_ids.size() - output_start[state];
+    }
+
+    // final table in breadth-first order, so the shallow states most scans stay in
+    // share cache lines. Entries hold the target row offset, top bit set if it has outputs.
+    std::vector<u32> rank(state_total, 0);
+    for (u32 r = 0; r < state_total; r++) rank[order[r]] = r;
+
+    std::vector<u32> start_by_rank(state_total), count_by_rank(state_total);
+    transitions.assign((size_t)state_total * class_count, 0);
+    for (u32 s = 0; s < state_total; s++) {
+        u32 row = rank[s];
+        start_by_rank[row] = output_start[s];
+        count_by_rank[row] = output_count[s];
+        for (u32 cls = 0; cls < class_count; cls++) {
+            u32 target = trie[s * class_count + cls];
+            u32 entry = rank[target] * class_count;
+            if (output_count[target] != 0) entry |= OUTPUT_FLAG;
+            transitions[(size_t)row * class_count + cls] = entry;
+        }
+    }
+    output_start.swap(start_by_rank);
+    output_count.swap(count_by_rank);
+    built = 1;
+}
+
+u32 AhoCorasick::scan(u8 text[], u32 len, MatchCallback on_match, void* user) const {
+    if (!built) return 0;
+    const u32* table = transitions.data();
+    u32 state = 0;                                  // row offset of the current state
+    u32 count = 0;
+    for (u32 i = 0; i < len; i++) {
+        u32 entry = table[state + byte_class[text[i]]];
+        state = entry & ~OUTPUT_FLAG;
+        if (entry & OUTPUT_FLAG) {
+            u32 s = state / class_count;
+            for (u32 k = 0; k < output_count[s]; k++) {
+                u32 id = output_ids[output_start[s] + k];
+                count++;
+                if (on_match != nullptr && !on_match(i + 1 - pattern_len[id], id, user)) return count;
+            }
+        }
+    }
+    return count;
+}
+
+u32 AhoCorasick::state_count() const {
+    return class_count == 0 ? 0 : (u32)(transitions.size() / class_count);
+}
@@ -0,0 +1,99 @@
+// Bit, SWAR and x86 vector helpers shared by the string_lib source files.
+// Internal header: only include it from string_lib .cpp files.
+
+#include "custom_datatypes.h"
+
+#ifndef STRING_SIMD_H
+#define STRING_SIMD_H
+
+#include <stdint.h>
+#include <string.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define STRING_LIB_X86 1
+#include <immintrin.h>
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define STRING_LIB_X86 0
+#endif
+
+// --- bit helpers ---
+
+// index of the lowest set bit, x must not be 0
+static inline u32 lowest_bit(u64 x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (u32)__builtin_ctzll(x);
+#else
+    u32 i = 0;
+    while ((x & 1) == 0) { x >>= 1; i++; }
+    return i;
+#endif
+}
+
+// index of the highest set bit, x must not be 0
+static inline u32 highest_bit(u64 x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - (u32)__builtin_clzll(x);
+#else
+    u32 i = 0;
+    while (x >>= 1) i++;
+    return i;
+#endif
+}
+
+// --- SWAR helpers (8 bytes inside a u64) ---
+
+#define SWAR_ONES  0x0101010101010101ULL
+#define SWAR_LOWS  0x7F7F7F7F7F7F7F7FULL
+#define SWAR_HIGHS 0x8080808080808080ULL
+
+static inline u64 load_u64(const u8* p) {
+    u64 v;
+    memcpy(&v, p, sizeof(v));   // compiles to a single load
+    return v;
+}
+
+// non-zero if one of the 8 bytes is 0 (may flag extra bytes after the first zero)
+static inline u64 swar_has_zero(u64 v) {
+    return (v - SWAR_ONES) & ~v & SWAR_HIGHS;
+}
+
+// 0x80 in exactly the bytes that are 0
+static inline u64 swar_zero_bytes(u64 v) {
+    return ~(((v & SWAR_LOWS) + SWAR_LOWS) | v | SWAR_LOWS);
+}
+
+// position in memory of the first flagged byte of a swar mask
+static inline u32 swar_first_byte(u64 mask) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (63 - highest_bit(mask)) / 8;
+#else
+    return lowest_bit(mask) / 8;
+#endif
+}
+
+// convert the 8 bytes of v, first is 'a' or 'A'
+static inline u64 swar_case(u64 v, u8 first, bool_t upper) {
+    u64 b    = v & SWAR_LOWS;
+    u64 ge   = b + SWAR_ONES * (u64)(0x80 - first);         // high bit set if byte >= first
+    u64 gt   = b + SWAR_ONES * (u64)(0x80 - first - 26);    // high bit set if byte > last
+    u64 mask = ge & ~gt & ~v & SWAR_HIGHS;                  // 0x80 in every letter to convert
+    return upper ? v - (mask >> 2) : v + (mask >> 2);       // 0x80 >> 2 == 0x20
+}
+
+// clear the flag of the first byte (in memory order) of a swar mask
+static inline u64 swar_clear_first_byte(u64 mask) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return mask & ~((u64)1 << highest_bit(mask));
+#else
+    return mask & (mask - 1);
+#endif
+}
+
+// 0x80 in exactly the bytes that are not 0
+static inline u64 swar_nonzero_bytes(u64 v) {
+    return (((v & SWAR_LOWS) + SWAR_LOWS) | v) & SWAR_HIGHS;
+}
+
+#endif // STRING_SIMD_H
@@ -0,0 +1,229 @@
+#include "string_lib.h"
+#include "string_simd.h"
+
+#include <string.h>
+
+// --- byte sets ---
+
+void byte_set_init(ByteSet* set, const u8 bytes[], u32 count) {
+    set->count = 0;
+    for (u32 k = 0; k < 4; k++) set->member[k] = 0;
+    for (u32 i = 0; i < count; i++) {
+        u8 c = bytes[i];
+        if (byte_set_has(set, c)) continue;
+        set->member[c >> 6] |= (u64)1 << (c & 63);
+        if (set->count < BYTE_SET_MAX_VECTOR) set->bytes[set->count] = c;
+        set->count++;
+    }
+}
+
+// bits beyond len in the last word are cleared
+static inline u64 keep_first_bits(u64 word, u32 n) {
+    return n >= 64 ? word : word & (((u64)1 << n) - 1);
+}
+
+// --- byte set bitmap kernels ---
+// Bit i of bits[] is set when data[i] is in the set, one u64 word per 64 bytes.
+
+void byte_set_bitmap_scalar(u8 data[], u32 len, const ByteSet* set, u64 bits[]) {
+    for (u32 w = 0; w * 64 < len; w++) {
+        u32 n = len - w * 64 < 64 ? len - w * 64 : 64;
+        u64 word = 0;
+        for (u32 k = 0; k < n; k++) {
+            word |= (u64)byte_set_has(set, data[w * 64 + k]) << k;
+        }
+        bits[w] = word;
+    }
+}
+
+// flags (0x80 per byte) for the set members among 8 bytes
+static inline u64 swar_byte_set(u64 v, const ByteSet* set) {
+    u64 hits = 0;
+    for (u32 k = 0; k < set->count; k++) {
+        hits |= swar_zero_bytes(v ^ (SWAR_ONES * set->bytes[k]));
+    }
+    return hits;
+}
+
+// one bit per byte from a swar flag word, first byte in bit 0
+static inline u32 swar_gather_bits(u64 flags) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    flags = __builtin_bswap64(flags);
+#endif
+    return (u32)(((flags >> 7) * 0x0102040810204080ULL) >> 56);
+}
+
+void byte_set_bitmap_swar(u8 data[], u32 len, const ByteSet* set, u64 bits[]) {
+    if (set->count > BYTE_SET_MAX_VECTOR) {
+        byte_set_bitmap_scalar(data, len, set, bits);
+        return;
+    }
+    u32 w = 0;
+    for (; (w + 1) * 64 <= len; w++) {
+        u64 word = 0;
+        for (u32 k = 0; k < 8; k++) {
+            word |= (u64)swar_gather_bits(swar_byte_set(load_u64(data + w * 64 + k * 8), set)) << (k * 8);
+        }
+        bits[w] = word;
+    }
+    if (w * 64 < len) {
+        byte_set_bitmap_scalar(data + w * 64, len - w * 64, set, bits + w);
+    }
+}
+
+#if STRING_LIB_X86
+
+TARGET_SSE2
+void byte_set_bitmap_sse2(u8 data[], u32 len, const ByteSet* set, u64 bits[]) {
+    if (set->count > BYTE_SET_MAX_VECTOR) {
+        byte_set_bitmap_scalar(data, len, set, bits);
+        return;
+    }
+    __m128i members[BYTE_SET_MAX_VECTOR];
+    for (u32 k = 0; k < set->count; k++) members[k] = _mm_set1_epi8((char)set->bytes[k]);
+
+    u8 tail[64];
+    for (u32 w = 0; w * 64 < len; w++) {
+        const u8* p = data + w * 64;
+        u32 n = len - w * 64;
+        if (n < 64) {
+            // last partial word: work on a padded copy, then drop the padding bits
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, p, n);
+            p = tail;
+        }
+        u64 word = 0;
+        for (u32 q = 0; q < 4; q++) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(p + q * 16));
+            __m128i hit = _mm_setzero_si128();
+            for (u32 k = 0; k < set->count; k++) hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, members[k]));
+            word |= (u64)(u32)_mm_movemask_epi8(hit) << (q * 16);
+        }
+        bits[w] = keep_first_bits(word, n);
+    }
+}
+
+TARGET_AVX2
+void byte_set_bitmap_avx2(u8 data[], u32 len, const ByteSet* set, u64 bits[]) {
+    if (set->count > BYTE_SET_MAX_VECTOR) {
+        byte_set_bitmap_scalar(data, len, set, bits);
+        return;
+    }
+    __m256i members[BYTE_SET_MAX_VECTOR];
+    for (u32 k = 0; k < set->count; k++) members[k] = _mm256_set1_epi8((char)set->bytes[k]);
+
+    u8 tail[64];
+    for (u32 w = 0; w * 64 < len; w++) {
+        const u8* p = data + w * 64;
+        u32 n = len - w * 64;
+        if (n < 64) {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, p, n);
+            p = tail;
+        }
+        __m256i lo = _mm256_loadu_si256((const __m256i*)p);
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(p + 32));
+        __m256i hit_lo = _mm256_setzero_si256();
+        __m256i hit_hi = _mm256_setzero_si256();
+        for (u32 k = 0; k < set->count; k++) {
+            hit_lo = _mm256_or_si256(hit_lo, _mm256_cmpeq_epi8(lo, members[k]));
+            hit_hi = _mm256_or_si256(hit_hi, _mm256_cmpeq_epi8(hi, members[k]));
+        }
+        u64 word = (u64)(u32)_mm256_movemask_epi8(hit_lo) | ((u64)(u32)_mm256_movemask_epi8(hit_hi) << 32);
+        bits[w] = keep_first_bits(word, n);
+    }
+}
+
+#else
+
+void byte_set_bitmap_sse2(u8 data[], u32 len, const ByteSet* set, u64 bits[]) { byte_set_bitmap_swar(data, len, set, bits); }
+void byte_set_bitmap_avx2(u8 data[], u32 len, const ByteSet* set, u64 bits[]) { byte_set_bitmap_swar(data, len, set, bits); }
+
+#endif
+
+// --- tokenizer ---
+
+Tokenizer::Tokenizer(u8 text[], u32 text_len, const char* delimiters, u8 quote_char, bool_t skip_empty_fields)
+    : data(text), len(text_len), quote(quote_char), skip_empty(skip_empty_fields),
+      window_start(0), window_len(0), pos(0), done(0) {
+    u8 members[257];
+    u32 count = 0;
+    for (const char* d = delimiters; *d != '\0' && count < 256; d++) members[count++] = (u8)*d;
+    byte_set_init(&delims, members, count);
+    if (quote != 0) members[count++] = quote;
+    byte_set_init(&specials, members, count);
+    kernel = string_kernels()->byte_set_bitmap;
+}
+
+// position of the first special byte at or after p, len if none. Refills the
+// bitmap window (one kernel call per TOKEN_WINDOW bytes) when p runs past it.
+inline u32 Tokenizer::next_special(u32 p) {
+    for (;;) {
+        if (p >= len) return len;
+        if (p < window_start || p >= window_start + window_len) {
+            window_start = p & ~(u32)63;
+            window_len = len - window_start < TOKEN_WINDOW ? len - window_start : TOKEN_WINDOW;
+            kernel(data + window_start, window_len, &specials, bits);
+        }
+        u32 rel = p - window_start;
+        u32 w = rel / 64;
+        u64 word = bits[w] & (~(u64)0 << (rel % 64));
+        for (;;) {
+            if (word != 0) return window_start + w * 64 + lowest_bit(word);
+            w++;
+            if (w * 64 >= window_len) break;
+            word = bits[w];
+        }
+        p = window_start + window_len;
+    }
+}
+
+// first delimiter at or after p (quotes inside an unquoted field are plain bytes)
+inline u32 Tokenizer::next_delimiter(u32 p) {
+    u32 e = next_special(p);
+    while (e < len && !byte_set_has(&delims, data[e])) e = next_special(e + 1);
+    return e;
+}
+
+u32 Tokenizer::next_batch(Span out[], u32 max) {
+    u32 count = 0;
+    while (count < max && !done) {
+        u32 start = pos;
+        Span span;
+        u32 end;
+
+        if (quote != 0 && start < len && data[start] == quote) {
+            // quoted field: runs to the closing quote, "" inside is an escaped quote
+            u32 q = start + 1;
+            for (;;) {
+                q = next_special(q);
+                if (q >= len) break;                        // unterminated: take the rest
+                if (data[q] != quote) { q++; continue; }
+                if (q + 1 < len && data[q + 1] == quote) { q += 2; continue; }
+                break;
+            }
+            span.offset = start + 1;
+            span.len = (q < len ? q : len) - span.offset;
+            end = q < len ? next_delimiter(q + 1) : len;
+        } else {
+            end = next_delimiter(start);
+            span.offset = start;
+            span.len = end - start;
+        }
+
+        if (end >= len) {
+            done = 1;
+        } else {
+            pos = end + 1;
+        }
+        if (skip_empty && span.len == 0 && !(quote != 0 && start < len && data[start] == quote)) {
+            continue;
+        }
+        out[count++] = span;
+    }
+    return count;
+}
+
+bool_t Tokenizer::next(Span* out) {
+    return next_batch(out, 1) == 1;
+}
@@ -0,0 +1,411 @@
+#include "string_lib.h"
+#include "string_simd.h"
+
+#include <string.h>
+
+// --- one UTF-8 sequence at a time ---
+
+#define UTF8_BAD 0xFFFFFFFFu
+
+// length of the well-formed sequence starting at str[i] (Unicode table 3-7:
+// no overlongs, no surrogates, nothing above U+10FFFF), UTF8_BAD if malformed
+static inline u32 utf8_sequence_length(const u8* str, u32 len, u32 i) {
+    u8 c = str[i];
+    if (c < 0x80) return 1;
+    if (c < 0xC2) return UTF8_BAD;                  // stray continuation or overlong 2-byte lead
+
+    u32 need;
+    u8 lo = 0x80, hi = 0xBF;                        // allowed range of the second byte
+    if (c < 0xE0) {
+        need = 2;
+    } else if (c < 0xF0) {
+        need = 3;
+        if (c == 0xE0) lo = 0xA0;                   // overlong
+        if (c == 0xED) hi = 0x9F;                   // surrogates
+    } else if (c < 0xF5) {
+        need = 4;
+        if (c == 0xF0) lo = 0x90;                   // overlong
+        if (c == 0xF4) hi = 0x8F;                   // above U+10FFFF
+    } else {
+        return UTF8_BAD;
+    }
+
+    if (need > len - i) return UTF8_BAD;
+    if (str[i + 1] < lo || str[i + 1] > hi) return UTF8_BAD;
+    for (u32 k = 2; k < need; k++) {
+        if ((str[i + k] & 0xC0) != 0x80) return UTF8_BAD;
+    }
+    return need;
+}
+
+// --- validation kernels ---
+
+bool_t utf8_validate_scalar(u8 str[], u32 len) {
+    u32 i = 0;
+    while (i < len) {
+        u32 n = utf8_sequence_length(str, len, i);
+        if (n == UTF8_BAD) return 0;
+        i += n;
+    }
+    return 1;
+}
+
+// skip 8 ASCII bytes at a time, decode anything else one sequence at a time
+bool_t utf8_validate_swar(u8 str[], u32 len) {
+    u32 i = 0;
+    while (i < len) {
+        if (i + 8 <= len && (load_u64(str + i) & SWAR_HIGHS) == 0) {
+            i += 8;
+            continue;
+        }
+        u32 n = utf8_sequence_length(str, len, i);
+        if (n == UTF8_BAD) return 0;
+        i += n;
+    }
+    return 1;
+}
+
+// --- case mapping ---
+// The two-byte range (U+0080..U+07FF) is mapped through a 2048-entry table indexed
+// by code point: Latin-1, Latin Extended-A, Greek (tonos letters and the micro sign
+// included) and Cyrillic letters whose other case is also two bytes long. Everything
+// else is copied unchanged, so the output always has the same length as the input and
+// can overwrite it.
+
+typedef struct {
+    u16 first;
+    u16 last;
+    i16 delta;          // added to the code point
+    u8  step;           // 1 = every code point in the range, 2 = every other one from first
+} CaseRange;
+
+static const CaseRange upper_to_lower[] = {
+    { 0x00C0, 0x00D6,  32, 1 }, { 0x00D8, 0x00DE,  32, 1 },
+    { 0x0100, 0x012E,   1, 2 }, { 0x0132, 0x0136,   1, 2 }, { 0x0139, 0x0147,   1, 2 },
+    { 0x014A, 0x0176,   1, 2 }, { 0x0178, 0x0178, -121, 1 }, { 0x0179, 0x017D,   1, 2 },
+    { 0x0386, 0x0386,  38, 1 }, { 0x0388, 0x038A,  37, 1 }, { 0x038C, 0x038C,  64, 1 },
+    { 0x038E, 0x038F,  63, 1 }, { 0x0391, 0x03A1,  32, 1 }, { 0x03A3, 0x03AB,  32, 1 },
+    { 0x0400, 0x040F,  80, 1 }, { 0x0410, 0x042F,  32, 1 },
+};
+
+static const CaseRange lower_to_upper[] = {
+    { 0x00E0, 0x00F6, -32, 1 }, { 0x00F8, 0x00FE, -32, 1 }, { 0x00FF, 0x00FF, 121, 1 },
+    { 0x0101, 0x012F,  -1, 2 }, { 0x0133, 0x0137,  -1, 2 }, { 0x013A, 0x0148,  -1, 2 },
+    { 0x014B, 0x0177,  -1, 2 }, { 0x017A, 0x017E,  -1, 2 }, { 0x00B5, 0x00B5, 743, 1 },
+    { 0x03AC, 0x03AC, -38, 1 }, { 0x03AD, 0x03AF, -37, 1 }, { 0x03CC, 0x03CC, -64, 1 },
+    { 0x03CD, 0x03CE, -63, 1 }, { 0x03B1, 0x03C1, -32, 1 }, { 0x03C2, 0x03C2, -31, 1 }, { 0x03C3, 0x03CB, -32, 1 },
+    { 0x0430, 0x044F, -32, 1 }, { 0x0450, 0x045F, -80, 1 },
+};
+
+typedef struct {
+    u16 to_upper[2048];
+    u16 to_lower[2048];
+} CaseTables;
+
+static void fill_case_table(u16 table[2048], const CaseRange* ranges, u32 count) {
+    for (u32 cp = 0; cp < 2048; cp++) table[cp] = (u16)cp;
+    for (u32 r = 0; r < count; r++) {
+        for (u32 cp = ranges[r].first; cp <= ranges[r].last; cp += ranges[r].step) {
+            table[cp] = (u16)(cp + ranges[r].delta);
+        }
+    }
+}
+
+// built once, on first use
+static const CaseTables& case_tables() {
+    static CaseTables tables = [] {
+        CaseTables t;
+        fill_case_table(t.to_upper, lower_to_upper, sizeof(lower_to_upper) / sizeof(lower_to_upper[0]));
+        fill_case_table(t.to_lower, upper_to_lower, sizeof(upper_to_lower) / sizeof(upper_to_lower[0]));
+        return t;
+    }();
+    return tables;
+}
+
+// convert the sequence at src[i] into dst[i], returns how many bytes it used
+static inline u32 utf8_case_sequence(u8 dst[], u8 src[], u32 len, u32 i, const u16* table, bool_t upper) {
+    u8 c = src[i];
+    if (c < 0x80) {
+        case_convert_scalar(dst + i, src + i, 1, upper);
+        return 1;
+    }
+    u32 n = utf8_sequence_length(src, len, i);
+    if (n == UTF8_BAD) {
+        dst[i] = c;                                 // malformed byte, pass it through
+        return 1;
+    }
+    if (n == 2) {
+        u32 cp = table[((u32)(c & 0x1F) << 6) | (src[i + 1] & 0x3F)];
+        dst[i] = (u8)(0xC0 | (cp >> 6));
+        dst[i + 1] = (u8)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    memmove(dst + i, src + i, n);
+    return n;
+}
+
+void utf8_case_convert_scalar(u8 dst[], u8 src[], u32 len, bool_t upper) {
+    const u16* table = upper ? case_tables().to_upper : case_tables().to_lower;
+    u32 i = 0;
+    while (i < len) {
+        i += utf8_case_sequence(dst, src, len, i, table, upper);
+    }
+}
+
+void utf8_case_convert_swar(u8 dst[], u8 src[], u32 len, bool_t upper) {
+    const u16* table = upper ? case_tables().to_upper : case_tables().to_lower;
+    u8 first = upper ? 'a' : 'A';
+    u32 i = 0;
+    while (i < len) {
+        if (i + 8 <= len) {
+            u64 v = load_u64(src + i);
+            if ((v & SWAR_HIGHS) == 0) {
+                v = swar_case(v, first, upper);
+                memcpy(dst + i, &v, sizeof(v));
+                i += 8;
+                continue;
+            }
+        }
+        i += utf8_case_sequence(dst, src, len, i, table, upper);
+    }
+}
+
+#if STRING_LIB_X86
+
+// skip 16 ASCII bytes at a time (SSE2 has no byte shuffle for the lookup validator)
+TARGET_SSE2
+bool_t utf8_validate_sse2(u8 str[], u32 len) {
+    u32 i = 0;
+    while (i < len) {
+        if (i + 16 <= len && _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(str + i))) == 0) {
+            i += 16;
+            continue;
+        }
+        u32 n = utf8_sequence_length(str, len, i);
+        if (n == UTF8_BAD) return 0;
+        i += n;
+    }
+    return 1;
+}
+
+// --- Keiser-Lemire lookup validator ---
+// Each byte is classified together with the byte before it through three 16-entry
+// nibble tables (high nibble of the previous byte, its low nibble, high nibble of
+// this byte). The AND of the three lookups is non-zero exactly where a 2-byte pattern
+// is illegal. Third/fourth continuation bytes are checked with two saturating subtracts.
+
+#define UTF8_TOO_SHORT  (1 << 0)    // lead byte not followed by a continuation
+#define UTF8_TOO_LONG   (1 << 1)    // ASCII followed by a continuation
+#define UTF8_OVERLONG_3 (1 << 2)
+#define UTF8_TOO_LARGE  (1 << 3)
+#define UTF8_SURROGATE  (1 << 4)
+#define UTF8_OVERLONG_2 (1 << 5)
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4 (1 << 6)
+#define UTF8_TWO_CONTS  (1 << 7)    // two continuations, fine only inside 3/4-byte sequences
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+// the 32 bytes ending n bytes before the start of cur (prev holds the block before)
+#define UTF8_PREV(cur, prev, n) _mm256_alignr_epi8((cur), _mm256_permute2x128_si256((prev), (cur), 0x21), 16 - (n))
+
+TARGET_AVX2
+static inline __m256i utf8_lookup(__m256i index, __m256i table) {
+    return _mm256_shuffle_epi8(table, index);
+}
+
+TARGET_AVX2
+static inline __m256i utf8_block_errors(__m256i input, __m256i prev_input) {
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+    const __m256i byte_1_high_table = _mm256_setr_epi8(
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+        UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+        UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+        UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+        UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+        UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+        UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4);
+    const __m256i byte_1_low_table = _mm256_setr_epi8(
+        UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+        UTF8_CARRY | UTF8_OVERLONG_2,
+        UTF8_CARRY,
+        UTF8_CARRY,
+        UTF8_CARRY | UTF8_TOO_LARGE,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+        UTF8_CARRY | UTF8_OVERLONG_2,
+        UTF8_CARRY,
+        UTF8_CARRY,
+        UTF8_CARRY | UTF8_TOO_LARGE,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000);
+    const __m256i byte_2_high_table = _mm256_setr_epi8(
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT);
+
+    __m256i prev1 = UTF8_PREV(input, prev_input, 1);
+    __m256i byte_1_high = utf8_lookup(_mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble), byte_1_high_table);
+    __m256i byte_1_low  = utf8_lookup(_mm256_and_si256(prev1, low_nibble), byte_1_low_table);
+    __m256i byte_2_high = utf8_lookup(_mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble), byte_2_high_table);
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    // bytes 2 or 3 after a 3/4-byte lead must be continuations (the TWO_CONTS case)
+    __m256i prev2 = UTF8_PREV(input, prev_input, 2);
+    __m256i prev3 = UTF8_PREV(input, prev_input, 3);
+    __m256i third  = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    __m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+    return _mm256_xor_si256(must_continue, special);
+}
+
+// non-zero where the block ends inside a sequence (checked against the next block)
+TARGET_AVX2
+static inline __m256i utf8_block_incomplete(__m256i input) {
+    const __m256i max_value = _mm256_setr_epi8(
+        (char)255, (char)255, (char)255, (char)255, (char)255, (char)255, (char)255, (char)255,
+        (char)255, (char)255, (char)255, (char)255, (char)255, (char)255, (char)255, (char)255,
+        (char)255, (char)255, (char)255, (char)255, (char)255, (char)255, (char)255, (char)255,
+        (char)255, (char)255, (char)255, (char)255, (char)255,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    return _mm256_subs_epu8(input, max_value);
+}
+
+TARGET_AVX2
+bool_t utf8_validate_avx2(u8 str[], u32 len) {
+    __m256i error = _mm256_setzero_si256();
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+
+    u32 i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i input = _mm256_loadu_si256((const __m256i*)(str + i));
+        if (_mm256_movemask_epi8(input) == 0) {
+            // pure ASCII: only a sequence left open by the previous block can be wrong
+            error = _mm256_or_si256(error, prev_incomplete);
+        } else {
+            error = _mm256_or_si256(error, utf8_block_errors(input, prev_input));
+            prev_incomplete = utf8_block_incomplete(input);
+        }
+        prev_input = input;
+    }
+
+    // the tail padded with zeros (ASCII), which also closes the last sequence
+    if (i < len) {
+        u8 tail[32] = { 0 };
+        memcpy(tail, str + i, len - i);
+        __m256i input = _mm256_loadu_si256((const __m256i*)tail);
+        error = _mm256_or_si256(error, utf8_block_errors(input, prev_input));
+        prev_incomplete = utf8_block_incomplete(input);
+    }
+    error = _mm256_or_si256(error, prev_incomplete);
+    return _mm256_testz_si256(error, error);
+}
+
+TARGET_SSE2
+void utf8_case_convert_sse2(u8 dst[], u8 src[], u32 len, bool_t upper) {
+    const u16* table = upper ? case_tables().to_upper : case_tables().to_lower;
+    u8 first = upper ? 'a' : 'A';
+    const __m128i shift = _mm_set1_epi8((char)(0x80 - first));
+    const __m128i limit = _mm_set1_epi8((char)(-128 + 26));
+    const __m128i flip  = _mm_set1_epi8(0x20);
+
+    u32 i = 0;
+    while (i < len) {
+        if (i + 16 <= len) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            if (_mm_movemask_epi8(v) == 0) {
+                __m128i d = _mm_and_si128(_mm_cmplt_epi8(_mm_add_epi8(v, shift), limit), flip);
+                v = upper ? _mm_sub_epi8(v, d) : _mm_add_epi8(v, d);
+                _mm_storeu_si128((__m128i*)(dst + i), v);
+                i += 16;
+                continue;
+            }
+        }
+        i += utf8_case_sequence(dst, src, len, i, table, upper);
+    }
+}
+
+TARGET_AVX2
+void utf8_case_convert_avx2(u8 dst[], u8 src[], u32 len, bool_t upper) {
+    const u16* table = upper ? case_tables().to_upper : case_tables().to_lower;
+    u8 first = upper ? 'a' : 'A';
+    const __m256i shift = _mm256_set1_epi8((char)(0x80 - first));
+    const __m256i limit = _mm256_set1_epi8((char)(-128 + 26));
+    const __m256i flip  = _mm256_set1_epi8(0x20);
+
+    u32 i = 0;
+    while (i < len) {
+        if (i + 32 <= len) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+            if (_mm256_movemask_epi8(v) == 0) {
+                // pure ASCII block, same kernel as case_convert_avx2
+                __m256i d = _mm256_and_si256(_mm256_cmpgt_epi8(limit, _mm256_add_epi8(v, shift)), flip);
+                v = upper ? _mm256_sub_epi8(v, d) : _mm256_add_epi8(v, d);
+                _mm256_storeu_si256((__m256i*)(dst + i), v);
+                i += 32;
+                continue;
+            }
+        }
+        i += utf8_case_sequence(dst, src, len, i, table, upper);
+    }
+}
+
+#else
+
+bool_t utf8_validate_sse2(u8 str[], u32 len) { return utf8_validate_swar(str, len); }
+bool_t utf8_validate_avx2(u8 str[], u32 len) { return utf8_validate_swar(str, len); }
+void utf8_case_convert_sse2(u8 dst[], u8 src[], u32 len, bool_t upper) { utf8_case_convert_swar(dst, src, len, upper); }
+void utf8_case_convert_avx2(u8 dst[], u8 src[], u32 len, bool_t upper) { utf8_case_convert_swar(dst, src, len, upper); }
+
+#endif
+
+// --- public entry points ---
+
+bool_t utf8_validate(u8 str[], u32 len) {
+    return string_kernels()->utf8_validate(str, len);
+}
+
+void utf8_to_upper(u8 dst[], u8 src[], u32 len) {
+    string_kernels()->utf8_case_convert(dst, src, len, 1);
+}
+
+void utf8_to_lower(u8 dst[], u8 src[], u32 len) {
+    string_kernels()->utf8_case_convert(dst, src, len, 0);
+}